@@ -2,6 +2,15 @@
 #include <fstream>
 #include <vector>
 #include <ctime>
+#include <cmath>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <atomic>
 using namespace std;
 
 int n = 100;
@@ -12,247 +21,630 @@ struct Court
 	double cell_x = len / n; // Размеры ячеек которые делят поле на nxn матрицу
 	double cell_y = width / n;
 } c;
-struct Agent
+
+enum Side { AGENT = 0, BOT = 1 }; // Индекс игрока в массиве p
+
+struct Player
 {
-	//Начальные значения
-	double pos_x = 0; //Длина
-	double pos_y = c.width / 2; //Ширина
+	double pos_x; //Длина
+	double pos_y; //Ширина
 	double r;
 	double l;
 	int ball = 0; // Если счет равный - играем до 2 мячей
 	int score = 0;
 	int set = 0;
 	bool winner = false;
-} a;
-struct Bot
-{
-	double pos_x = c.len / 2;
-	double pos_y = c.width / 2;
-	double r;
-	double l;
-	int ball = 0;
-	int score = 0;
-	int set = 0;
-	bool winner = false;
-} b;
+};
 
-bool setIsDone() {
-	if (a.score > 40 && b.score < 40) { //Agent
-		a.set++;
-		a.score = 0;
-		a.ball = 0;
-		b.score = 0;
-		b.ball = 0;
-		return false;
-	}
-	else if (a.score < 40 && b.score > 40) { //Bot
-		b.set++;
-		a.score = 0;
-		a.ball = 0;
-		b.score = 0;
-		b.ball = 0;
-		return false;
+// Начальные позиции: агент у задней линии, бот в середине своей половины
+const double start_x[2] = { 0, c.len / 2 };
+
+Player p[2] = {
+	{ start_x[AGENT], c.width / 2, 0, 0, 0, 0, 0, false },
+	{ start_x[BOT], c.width / 2, 0, 0, 0, 0, 0, false }
+};
+Player& a = p[AGENT];
+Player& b = p[BOT];
+
+inline Side other(Side side) {
+	return Side(1 - side);
+}
+
+void resetGame() { // Обнуление счета гейма у обоих игроков
+	for (Player& q : p) {
+		q.score = 0;
+		q.ball = 0;
 	}
-	if (a.score == 40 && b.score == 40) {
-		if (a.ball - b.ball >= 2) { //Agent
-			a.set++;
-			a.score = 0;
-			a.ball = 0;
-			b.score = 0;
-			b.ball = 0;
+}
+
+bool setIsDone() {
+	for (int s = 0; s < 2; s++) {
+		Player& me = p[s];
+		Player& op = p[1 - s];
+		if (me.score > 40 && op.score < 40) {
+			me.set++;
+			resetGame();
 			return false;
 		}
-		else if (b.ball - a.ball >= 2) { //Bot
-			b.set++;
-			a.score = 0;
-			a.ball = 0;
-			b.score = 0;
-			b.ball = 0;
+		if (me.score == 40 && op.score == 40 && me.ball - op.ball >= 2) {
+			me.set++;
+			resetGame();
 			return false;
 		}
 	}
 	return true;
 }
 
-void movePlayer(double x, double y, string player) {
-	if (player == "agent") {
-		double dx = x - a.pos_x;
-		double dy = y - a.pos_y;
-		double dist = sqrt(dx * dx + dy * dy);
-		if (dist < a.l) {
-			a.pos_x = x;
-			b.pos_y = y;
-		}
-		else {
-			double scale = dist / a.l;
-			a.pos_x += dx * scale;
-			a.pos_y += dy * scale;
-		}
+void movePlayer(double x, double y, Side side) {
+	Player& q = p[side];
+	double dx = x - q.pos_x;
+	double dy = y - q.pos_y;
+	double dist = sqrt(dx * dx + dy * dy);
+	if (dist < q.l) {
+		q.pos_x = x;
+		q.pos_y = y;
 	}
 	else {
-		double dx = x - b.pos_x;
-		double dy = y - b.pos_y;
-		double dist = sqrt(dx * dx + dy * dy);
-		if (dist < b.l) {
-			b.pos_x = x;
-			b.pos_y = y;
-		}
-		else {
-			double scale = dist / a.l;
-			b.pos_x += dx * scale;
-			b.pos_y += dy * scale;
+		double scale = dist / q.l;
+		q.pos_x += dx * scale;
+		q.pos_y += dy * scale;
+	}
+}
+
+bool hit(double x, double y, Side striker) {
+	Side side = other(striker);
+	Player& q = p[side];
+	movePlayer(x, y, side); // Во время удара противник двигается в точку падения мяча
+	double dx = x - q.pos_x;
+	double dy = y - q.pos_y;
+	double dist = sqrt(dx * dx + dy * dy);
+	if (dist <= q.r && (side != AGENT || x >= q.pos_x)) { //Агент отбивает только мяч в полукруге перед собой
+		return false; //Отбил
+	}
+	return true; // Не отбил
+}
+
+void addScore(Side side) {
+	Player& q = p[side];
+	if (a.score == 40 && b.score == 40) {
+		q.ball++;
+	}
+	else if (q.score >= 30) {
+		q.score += 10;
+	}
+	else {
+		q.score += 15;
+	}
+}
+void hasWinner() {
+	if (a.set == 2) a.winner = true;
+	else if (b.set == 2) b.winner = true;
+}
+void clearPos() {
+	for (int s = 0; s < 2; s++) {
+		p[s].pos_x = start_x[s];
+		p[s].pos_y = c.width / 2;
+	}
+}
+
+// Старая передача игрока строкой. Нужна только бенчмарку для сравнения "до/после"
+Side sideOf(string player) {
+	return player == "agent" ? AGENT : BOT;
+}
+
+template <bool ByName>
+inline Side pick(Side side) {
+	if (ByName) return sideOf(side == AGENT ? "agent" : "bot");
+	return side;
+}
+
+// Удар в ответ: случайная точка с возможным промахом. false - мяч в ауте
+bool randomShot(double& posx, double& posy) {
+	int rand_x = rand() % 110 + 1;
+	int rand_y = rand() % 110 + 1;
+	int miss = rand() % 100;
+	if (miss < 2) rand_x++;
+	else if (miss < 3) rand_x--;
+	else if (miss < 4) rand_y++;
+	else if (miss < 5) rand_y--;
+	if (rand_x > 100 || rand_y > 100) return false; //аут
+	posx = rand_x * c.cell_x;
+	posy = rand_y * c.cell_y;
+	return true;
+}
+
+// Розыгрыш одного мяча: подача агента и обмен ударами до первой ошибки.
+// Возвращает того, кто выиграл мяч
+template <bool ByName = false>
+Side playRally() {
+	int rand_x = rand() % 100 + 1;
+	int rand_y = rand() % 100 + 1;
+	double posx = rand_x * c.cell_x;
+	double posy = rand_y * c.cell_y;
+	Side striker = AGENT;
+	if (!hit(posx, posy, pick<ByName>(striker))) {
+		while (true) {
+			striker = other(striker);
+			if (!randomShot(posx, posy)) {
+				striker = other(striker); // Очко получает соперник
+				break;
+			}
+			if (hit(posx, posy, pick<ByName>(striker))) break;
 		}
 	}
+	clearPos();
+	return striker;
 }
 
-bool hit(double x,double y,string player) {
-	if (player == "agent") {//Бьет агент
-		movePlayer(x, y,"bot"); // Во время удара противник двигается в точку падения мяча
-		double dx = x - b.pos_x;
-		double dy = y - b.pos_y;
-		double dist = sqrt(dx * dx + dy * dy);
-		if (dist <= b.r) {
-			//cout << "Bot otbil, dist= "<<dist<<'\n';
-			return false; //Отбил
+template <bool ByName = false>
+void playPoint() {
+	addScore(pick<ByName>(playRally<ByName>()));
+}
+
+// Матч до двух выигранных геймов. true - победил агент
+template <bool ByName = false>
+bool playMatch() {
+	a.winner = b.winner = false;
+	a.set = b.set = 0;
+	while (!a.winner && !b.winner) {
+		while (setIsDone()) {
+			playPoint<ByName>();
 		}
-		//cout << "Agent get score, dist= " << dist << '\n';
-		return true; // Не отбил
+		hasWinner();
+	}
+	return a.winner;
+}
+
+// Сколько розыгрышей в секунду успевает сделать симуляция
+template <bool ByName>
+double benchRallies(int points) {
+	srand(1);
+	resetGame();
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < points; i++) {
+		playPoint<ByName>();
+		if (!setIsDone()) a.set = b.set = 0;
+	}
+	auto end = chrono::high_resolution_clock::now();
+	double sec = chrono::duration<double>(end - start).count();
+	return points / sec;
+}
+
+void bench() {
+	a.l = b.l = 1;
+	b.r = 5;
+	a.r = 10;
+	int points = 5000000;
+	double by_name = benchRallies<true>(points);
+	double by_side = benchRallies<false>(points);
+	cout << "string dispatch: " << by_name << " rallies/sec\n";
+	cout << "enum dispatch:   " << by_side << " rallies/sec\n";
+	cout << "speedup: " << by_side / by_name << '\n';
+}
+
+// Пачечный движок: LANES независимых матчей идут в одном цикле по дорожкам.
+// Все поля - массивы по дорожкам (SoA), удар считается без ветвлений, поэтому
+// в Release (/fp:fast) компилятор векторизует цикл. Скалярный playMatch остается эталоном.
+const int LANES = 8;
+
+struct Lanes
+{
+	double ax[LANES], ay[LANES]; // Позиция агента
+	double bx[LANES], by[LANES]; // Позиция бота
+	double ar[LANES], br[LANES]; // Досягаемость
+	double l[LANES];
+	uint32_t rng[LANES]; // У каждой дорожки свой генератор
+	int striker[LANES]; // Кто бьет (AGENT/BOT)
+	int serve[LANES]; // 1 - следующий удар подача
+	int winner[LANES]; // Кто выиграл розыгрыш, -1 если мяч в игре
+	int score[2][LANES];
+	int ball[2][LANES];
+	int set[2][LANES];
+	int active[LANES]; // 0 - матч на дорожке закончен
+};
+
+inline uint32_t laneRand(uint32_t& s) { // xorshift32
+	s ^= s << 13;
+	s ^= s >> 17;
+	s ^= s << 5;
+	return s;
+}
+
+inline int laneRange(uint32_t v, int n) { // Равномерно 0..n-1 без деления
+	return int((uint64_t(v) * uint32_t(n)) >> 32);
+}
+
+void laneNewPoint(Lanes& L, int i) {
+	L.ax[i] = start_x[AGENT];
+	L.ay[i] = c.width / 2;
+	L.bx[i] = start_x[BOT];
+	L.by[i] = c.width / 2;
+	L.striker[i] = AGENT;
+	L.serve[i] = 1;
+	L.winner[i] = -1;
+}
+
+void laneNewMatch(Lanes& L, int i) {
+	for (int s = 0; s < 2; s++) {
+		L.score[s][i] = L.ball[s][i] = L.set[s][i] = 0;
 	}
-	else { //Бьет бот
-		movePlayer(x, y, "agent"); // Во время удара противник двигается в точку падения мяча
-		double dx = x - a.pos_x;
-		double dy = y - a.pos_y;
+	L.active[i] = 1;
+	laneNewPoint(L, i);
+}
+
+// Один удар на всех дорожках сразу. Завершенные дорожки считают вхолостую, но ничего не меняют
+void laneShot(Lanes& L) {
+	for (int i = 0; i < LANES; i++) {
+		// Читаем все поля дорожки заранее, чтобы выбор сторон был без переходов
+		int serve = L.serve[i];
+		int striker = L.striker[i];
+		int winner = L.winner[i];
+		double ax = L.ax[i], ay = L.ay[i];
+		double bx = L.bx[i], by = L.by[i];
+		double ar = L.ar[i], br = L.br[i];
+		double l = L.l[i];
+
+		int range = 110 - 10 * serve;
+		int x = laneRange(laneRand(L.rng[i]), range) + 1;
+		int y = laneRange(laneRand(L.rng[i]), range) + 1;
+		int miss = laneRange(laneRand(L.rng[i]), 100);
+		miss += serve * (100 - miss); // Подача без промаха
+		x += (miss < 2) - (miss == 2);
+		y += (miss == 3) - (miss == 4);
+		int out = (x > 100) | (y > 100);
+		double posx = x * c.cell_x;
+		double posy = y * c.cell_y;
+
+		int to_agent = striker == BOT; // Мяч принимает агент
+		double qx = to_agent ? ax : bx;
+		double qy = to_agent ? ay : by;
+		double qr = to_agent ? ar : br;
+		double dx = posx - qx;
+		double dy = posy - qy;
 		double dist = sqrt(dx * dx + dy * dy);
-		if (dist <= a.r && x >= a.pos_x) { //Проверка на то что мяч в полукруге
-			//cout << "Agent otbil, dist = " << dist << '\n';
-			return false; //Отбил
-		}
-		//cout << "Bot get score, dist = " << dist << '\n';
-		return true; // Не отбил
+		double scale = max(1.0, dist / l); // Как в movePlayer: ближе l - ровно в точку
+		qx += dx * scale;
+		qy += dy * scale;
+		dx = posx - qx;
+		dy = posy - qy;
+		int returned = (dx * dx + dy * dy <= qr * qr) & (!to_agent | (posx >= qx));
+
+		int live = L.active[i] & (winner < 0);
+		int moved = live & !out;
+		L.ax[i] = (moved & to_agent) ? qx : ax;
+		L.ay[i] = (moved & to_agent) ? qy : ay;
+		L.bx[i] = (moved & !to_agent) ? qx : bx;
+		L.by[i] = (moved & !to_agent) ? qy : by;
+
+		// Аут - очко принимающему, не отбил - очко бьющему
+		int receiver = 1 - striker;
+		int ends = live & (out | !returned);
+		int point = out ? receiver : striker;
+		L.winner[i] = ends ? point : winner;
+		L.striker[i] = live ? receiver : striker;
+		L.serve[i] = serve & !live;
 	}
 }
 
-void addScore(string player) {
-	if (a.score == 40 && b.score == 40) {
-		if (player == "agent") {
-			a.ball++;
+// Автомат счета: переносит итоги розыгрышей в геймы и матч, как addScore/setIsDone/hasWinner.
+// Закончившие матч дорожки снимаются и, пока есть бюджет, получают новый матч
+void laneScore(Lanes& L, int& started, int matches, int& agent_wins) {
+	for (int i = 0; i < LANES; i++) {
+		int w = L.winner[i];
+		if (w < 0) continue;
+		int o = 1 - w;
+		if (L.score[w][i] == 40 && L.score[o][i] == 40) {
+			L.ball[w][i]++;
 		}
 		else {
-			b.ball++;
+			L.score[w][i] += L.score[w][i] >= 30 ? 10 : 15;
 		}
-	}
-	else if (player == "agent") {
-		if (a.score >= 30) {
-			a.score += 10;
+		bool game = (L.score[w][i] > 40 && L.score[o][i] < 40) ||
+			(L.score[w][i] == 40 && L.score[o][i] == 40 && L.ball[w][i] - L.ball[o][i] >= 2);
+		if (game) {
+			L.set[w][i]++;
+			for (int s = 0; s < 2; s++) {
+				L.score[s][i] = L.ball[s][i] = 0;
+			}
 		}
-		else {
-			a.score += 15;
+		laneNewPoint(L, i);
+		if (L.set[w][i] == 2) {
+			if (w == AGENT) agent_wins++;
+			L.active[i] = 0;
+			if (started < matches) {
+				laneNewMatch(L, i);
+				started++;
+			}
 		}
 	}
-	else {
-		if (b.score >= 30) {
-			b.score += 10;
+}
+
+// Сыграть matches матчей на дорожках. Возвращает число побед агента
+int simulateLanes(double ra, double rb, double l, int matches, uint32_t seed) {
+	Lanes L;
+	int started = 0, agent_wins = 0;
+	for (int i = 0; i < LANES; i++) {
+		L.ar[i] = ra;
+		L.br[i] = rb;
+		L.l[i] = l;
+		L.rng[i] = (seed * LANES + i) * 2654435761u | 1; // Ненулевое состояние xorshift
+		laneNewMatch(L, i);
+		L.active[i] = started < matches;
+		started += L.active[i];
+	}
+	while (true) {
+		int alive = 0;
+		for (int i = 0; i < LANES; i++) alive += L.active[i];
+		if (alive == 0) break;
+		laneShot(L);
+		laneScore(L, started, matches, agent_wins);
+	}
+	return agent_wins;
+}
+
+// Сверка пачечного движка со скалярным по тем же r, что и основной прогон
+void compareLanes(double l) {
+	int matches = 2000;
+	a.l = b.l = l;
+	srand(1);
+	double scalar_sec = 0, lanes_sec = 0;
+	cout << "r scalar lanes z\n";
+	for (double r = 1; r <= 10; r++) {
+		b.r = r;
+		a.r = 2 * r;
+		auto t0 = chrono::high_resolution_clock::now();
+		int scalar = 0;
+		for (int i = 0; i < matches; i++) {
+			if (playMatch()) scalar++;
 		}
-		else {
-			b.score += 15;
+		auto t1 = chrono::high_resolution_clock::now();
+		int lanes = simulateLanes(a.r, b.r, l, matches, uint32_t(r));
+		auto t2 = chrono::high_resolution_clock::now();
+		scalar_sec += chrono::duration<double>(t1 - t0).count();
+		lanes_sec += chrono::duration<double>(t2 - t1).count();
+
+		double ps = double(scalar) / matches;
+		double pl = double(lanes) / matches;
+		double pm = (ps + pl) / 2;
+		double se = sqrt(pm * (1 - pm) * 2 / matches);
+		double z = se > 0 ? (pl - ps) / se : 0; // |z| > 3 - движки расходятся
+		cout << r << " " << ps << " " << pl << " " << z << '\n';
+	}
+	cout << "scalar: " << scalar_sec << " s, lanes: " << lanes_sec << " s\n";
+}
+
+// Аналитический режим. Мячи независимы (позиции сбрасываются перед каждой подачей),
+// поэтому счет - цепь Маркова с одной вероятностью p выиграть мяч
+
+// Вероятность выиграть мяч: короткая симуляция розыгрышей
+double pointWinProb(int rallies) {
+	int won = 0;
+	for (int i = 0; i < rallies; i++) {
+		if (playRally() == AGENT) won++;
+	}
+	return double(won) / rallies;
+}
+
+// Вероятность выиграть гейм. Состояние (i, j) - число выигранных мячей: 0,15,30,40.
+// При 40:40 игра идет до перевеса в 2 мяча: p^2 / (p^2 + q^2)
+double gameWinProb(double p) {
+	double q = 1 - p;
+	double P[5][5];
+	for (int i = 4; i >= 0; i--) {
+		for (int j = 4; j >= 0; j--) {
+			if (i == 4 && j == 4) continue;
+			if (i == 4) P[i][j] = 1;
+			else if (j == 4) P[i][j] = 0;
+			else if (i == 3 && j == 3) P[i][j] = p * p / (p * p + q * q);
+			else P[i][j] = p * P[i + 1][j] + q * P[i][j + 1];
 		}
 	}
+	return P[0][0];
 }
-void hasWinner() {
-	if (a.set == 2) a.winner = true;
-	else if (b.set == 2) b.winner = true;
+
+// Вероятность выиграть матч до need геймов (в main матч идет до 2)
+double matchWinProb(double g, int need = 2) {
+	vector<vector<double>> P(need + 1, vector<double>(need + 1, 0));
+	for (int i = need; i >= 0; i--) {
+		for (int j = need; j >= 0; j--) {
+			if (i == need && j == need) continue;
+			if (i == need) P[i][j] = 1;
+			else if (j == need) P[i][j] = 0;
+			else P[i][j] = g * P[i + 1][j] + (1 - g) * P[i][j + 1];
+		}
+	}
+	return P[0][0];
 }
-void clearPos() {
-	a.pos_x = 0;
-	a.pos_y = c.width / 2;
-	b.pos_x = c.len / 2;
-	b.pos_y = c.width / 2;
+
+// Точные вероятности по цепи Маркова и сверка с методом Монте-Карло
+void analytic(double l) {
+	int rallies = 20000;
+	int matches = 2000;
+	a.l = b.l = l;
+	srand(1);
+	double markov_sec = 0, mc_sec = 0;
+	cout << "r point game match monte_carlo\n";
+	for (double r = 1; r <= 10; r++) {
+		b.r = r;
+		a.r = 2 * r;
+		auto t0 = chrono::high_resolution_clock::now();
+		double pt = pointWinProb(rallies);
+		double g = gameWinProb(pt);
+		double m = matchWinProb(g);
+		auto t1 = chrono::high_resolution_clock::now();
+		double mc = double(simulateLanes(a.r, b.r, l, matches, uint32_t(r))) / matches;
+		auto t2 = chrono::high_resolution_clock::now();
+		markov_sec += chrono::duration<double>(t1 - t0).count();
+		mc_sec += chrono::duration<double>(t2 - t1).count();
+		cout << r << " " << pt << " " << g << " " << m << " " << mc << '\n';
+	}
+	cout << "markov: " << markov_sec << " s, monte carlo: " << mc_sec << " s\n";
+}
+
+// Развертка по (r, l) для нескольких отношений досягаемости a.r / b.r.
+// Сетка сгущается там, где доля побед проходит через 50%: ячейка делится на 4,
+// если в ее углах доля побед по разные стороны от 0.5 или сильно меняется.
+// Число матчей в точке тоже адаптивное: насыщенные точки останавливаются на первой пачке
+struct SweepPoint
+{
+	double r, l, ratio;
+	int matches = 0;
+	int wins = 0;
+	double rate() const { return matches ? double(wins) / matches : 0; }
+};
+
+struct SweepCell
+{
+	int i, j, size; // Левый нижний угол и сторона в узлах самой мелкой сетки
+};
+
+// Матчи пачками, пока доля побед неотличима от 0.5 (3 сигмы) и бюджет не исчерпан
+void evalPoint(SweepPoint& pt, uint32_t seed) {
+	const int batch = 64;
+	const int max_matches = 4096;
+	while (pt.matches < max_matches) {
+		pt.wins += simulateLanes(pt.ratio * pt.r, pt.r, pt.l, batch, seed + pt.matches);
+		pt.matches += batch;
+		double rate = pt.rate();
+		double se = sqrt(max(rate * (1 - rate), 0.25 / pt.matches) / pt.matches);
+		if (fabs(rate - 0.5) > 3 * se) break;
+	}
+}
+
+// Точки считаются независимо, поэтому раздаем их потокам по общему счетчику
+void evalParallel(vector<SweepPoint*>& pts, uint32_t seed) {
+	atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t k = next++; k < pts.size(); k = next++) {
+			evalPoint(*pts[k], seed * 2654435761u + uint32_t(k) * 40503u);
+		}
+	};
+	int threads = max(1u, thread::hardware_concurrency());
+	vector<thread> pool;
+	for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+	worker();
+	for (auto& t : pool) t.join();
 }
-int main() {
+
+void sweep(const string& filename) {
+	const double r_min = 1, r_max = 10;
+	const double l_min = 0.5, l_max = 5;
+	const int coarse = 8; // Ячеек по каждой оси на грубой сетке
+	const int depth = 3; // Сколько раз можно поделить ячейку
+	const int fine = coarse << depth; // Узлов мелкой сетки по оси
+	const double ratios[] = { 1, 1.5, 2, 3 };
+
+	ofstream f(filename);
+	f << "ratio r l matches agent_wins win_rate\n";
+	auto start = chrono::high_resolution_clock::now();
+	long long total_matches = 0;
+	size_t total_points = 0;
+
+	for (double ratio : ratios) {
+		map<pair<int, int>, SweepPoint> points;
+		auto node = [&](int i, int j) -> SweepPoint& {
+			auto it = points.find({ i, j });
+			if (it == points.end()) {
+				SweepPoint pt;
+				pt.r = r_min + (r_max - r_min) * i / fine;
+				pt.l = l_min + (l_max - l_min) * j / fine;
+				pt.ratio = ratio;
+				it = points.emplace(make_pair(i, j), pt).first;
+			}
+			return it->second;
+		};
+
+		vector<SweepCell> cells;
+		for (int i = 0; i < coarse; i++) {
+			for (int j = 0; j < coarse; j++) {
+				cells.push_back({ i << depth, j << depth, 1 << depth });
+			}
+		}
+
+		for (int level = 0; ; level++) {
+			// Досчитываем узлы, которых еще нет
+			vector<SweepPoint*> todo;
+			for (const SweepCell& cell : cells) {
+				for (int di = 0; di <= 1; di++) {
+					for (int dj = 0; dj <= 1; dj++) {
+						SweepPoint& pt = node(cell.i + di * cell.size, cell.j + dj * cell.size);
+						if (pt.matches == 0 && find(todo.begin(), todo.end(), &pt) == todo.end()) {
+							todo.push_back(&pt);
+						}
+					}
+				}
+			}
+			evalParallel(todo, uint32_t(level * 7919 + ratio * 1000));
+			if (level == depth) break;
+
+			// Делим только ячейки на переходе через 50%
+			vector<SweepCell> refined;
+			for (const SweepCell& cell : cells) {
+				double lo = 1, hi = 0;
+				for (int di = 0; di <= 1; di++) {
+					for (int dj = 0; dj <= 1; dj++) {
+						double rate = node(cell.i + di * cell.size, cell.j + dj * cell.size).rate();
+						lo = min(lo, rate);
+						hi = max(hi, rate);
+					}
+				}
+				if ((lo <= 0.5 && hi >= 0.5) || hi - lo > 0.25) {
+					int h = cell.size / 2;
+					refined.push_back({ cell.i, cell.j, h });
+					refined.push_back({ cell.i + h, cell.j, h });
+					refined.push_back({ cell.i, cell.j + h, h });
+					refined.push_back({ cell.i + h, cell.j + h, h });
+				}
+			}
+			cells.swap(refined);
+		}
+
+		for (const auto& it : points) {
+			const SweepPoint& pt = it.second;
+			f << pt.ratio << " " << pt.r << " " << pt.l << " " << pt.matches << " " << pt.wins << " " << pt.rate() << '\n';
+			total_matches += pt.matches;
+		}
+		total_points += points.size();
+		cout << "ratio " << ratio << ": " << points.size() << " points\n";
+	}
+
+	auto end = chrono::high_resolution_clock::now();
+	cout << total_points << " points, " << total_matches << " matches, "
+		<< chrono::duration<double>(end - start).count() << " s\n";
+	cout << "uniform grid would need " << (fine + 1) * (fine + 1) * 4 << " points\n";
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 1 && string(argv[1]) == "bench") {
+		bench();
+		return 0;
+	}
+	if (argc > 1 && string(argv[1]) == "lanes") {
+		compareLanes(argc > 2 ? atof(argv[2]) : 1.0);
+		return 0;
+	}
+	if (argc > 1 && string(argv[1]) == "analytic") {
+		analytic(argc > 2 ? atof(argv[2]) : 1.0);
+		return 0;
+	}
+	if (argc > 1 && string(argv[1]) == "sweep") {
+		sweep(argc > 2 ? argv[2] : "sweep.txt");
+		return 0;
+	}
 	ofstream f("file.txt");
 	srand(time(NULL));
 	cout << "\nEnter l: "; cin >> a.l;
 	b.l = a.l;
 
-	for (double r = 1; r <= 10; r++) { // для разных r 
+	for (double r = 1; r <= 10; r++) { // для разных r
 		b.r = a.r = r;
 		a.r *= 2;
 		int count = 0;
 		for (int i = 0; i < 100; i++) { //100 раз тестируем
-			a.winner = b.winner = false;
-			a.set = b.set = 0;
-			while (!a.winner && !b.winner) {
-				while (setIsDone()) {
-					bool game = true;
-					int rand_x = rand() % 100 + 1;
-					int rand_y = rand() % 100 + 1;
-					double posx = rand_x * c.cell_x;
-					double posy = rand_y * c.cell_y;
-					if (hit(posx, posy, "agent")) {
-						addScore("agent");
-						//cout << a.score << " : " << b.score << '\n';
-						//cout << a.set << " : " << b.set << '\n';
-						game = false;
-					}
-					while (game) {
-						int rand_x = rand() % 110 + 1; //Бот
-						int rand_y = rand() % 110 + 1;
-						int miss = rand() % 100;
-						if (miss < 2) rand_x++;
-						else if (miss < 3) rand_x--;
-						else if (miss < 4) rand_y++;
-						else if (miss < 5) rand_y--;
-						if (rand_x > 100 || rand_y > 100) { //аут
-							addScore("agent");
-							//cout << "Bot hit at aut\n";
-							//cout << a.score << " : " << b.score << '\n';
-							//cout << a.set << " : " << b.set << '\n';
-							break;
-						}
-						double posx = rand_x * c.cell_x;
-						double posy = rand_y * c.cell_y;
-						if (hit(posx, posy, "bot")) {
-							addScore("bot");
-							//cout << a.score << " : " << b.score << '\n';
-							//cout << a.set << " : " << b.set << '\n';
-							break;
-						}
-
-						rand_x = rand() % 110 + 1;//Агент
-						rand_y = rand() % 110 + 1;
-						miss = rand() % 100;
-						if (miss < 2) rand_x++;
-						else if (miss < 3) rand_x--;
-						else if (miss < 4) rand_y++;
-						else if (miss < 5) rand_y--;
-						if (rand_x > 100 || rand_y > 100) { //аут
-							addScore("bot");
-							//cout << "Agent hit at aut\n";
-							//cout << a.score << " : " << b.score << '\n';
-							//cout << a.set << " : " << b.set << '\n';
-							break;
-						}
-						posx = rand_x * c.cell_x;
-						posy = rand_y * c.cell_y;
-						if (hit(posx, posy, "agent")) {
-							addScore("agent");
-							//cout << a.score << " : " << b.score << '\n';
-							//cout << a.set << " : " << b.set << '\n';
-							break;
-						}
-					}
-					clearPos();
-				}
-				//cout << "\n___________________________________\n";
-				hasWinner();
-			}
-			if (a.winner) count++;
-			string text = a.winner ? "Agent win" : "Bot win";
-			//cout << text << '\n';
-			//cout << a.set << " : " << b.set << '\n';
+			if (playMatch()) count++;
 		}
 		f << r << " " << count << " " << 100 - count <<'\n';
 		cout << r << " " << count << " " << 100 - count << '\n';
 	}
-	
-}
\ No newline at end of file
+
+}
@@ -2,12 +2,90 @@
 #include <vector>
 #include <cmath>
 #include <fstream>
+#include <algorithm>
+#include <deque>
+#include <array>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <complex>
+#include <limits>
+#include <charconv>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
 
 // Функция Хевисайда
 double heaviside(double t) {
     return (t >= 0) ? 1.0 : 0.0;
 }
 
+// Запаздывание в шагах. Округляем до ближайшего: 0.6 / 0.01 = 59.999... должно дать 60
+int delaySteps(double tau, double dt) {
+    return static_cast<int>(tau / dt + 0.5);
+}
+
+// Линия задержки фиксированной емкости: хранит последние delay_steps + 1 значений.
+// Память O(задержки), в step нет роста и перевыделения вектора
+class DelayLine {
+private:
+    std::vector<double> buffer;
+    size_t head;        // Индекс последнего записанного значения
+
+public:
+    explicit DelayLine(int delay_steps, double initial = 0.0)
+        : buffer(delay_steps + 1, initial), head(0) {}
+
+    // Значение delay_steps шагов назад (до начала моделирования - начальное значение)
+    double delayed() const {
+        size_t oldest = head + 1;
+        return buffer[oldest == buffer.size() ? 0 : oldest];
+    }
+
+    double current() const {
+        return buffer[head];
+    }
+
+    // Запись нового значения на место самого старого
+    void push(double value) {
+        if (++head == buffer.size()) head = 0;
+        buffer[head] = value;
+    }
+
+    void reset(double initial = 0.0) {
+        std::fill(buffer.begin(), buffer.end(), initial);
+        head = 0;
+    }
+};
+
+// Необязательный наблюдатель, записывающий полную историю x(t) и x'(t)
+class HistoryRecorder {
+private:
+    std::vector<double> x_history;      // История x(t)
+    std::vector<double> dx_history;     // История x'(t)
+
+public:
+    void record(double x, double dx) {
+        x_history.push_back(x);
+        dx_history.push_back(dx);
+    }
+
+    const std::vector<double>& getHistory() const {
+        return x_history;
+    }
+
+    const std::vector<double>& getDerivativeHistory() const {
+        return dx_history;
+    }
+
+    void clear() {
+        x_history.clear();
+        dx_history.clear();
+    }
+};
+
 // Класс для моделирования динамической системы второго порядка
 class DynamicSystem {
 private:
@@ -15,30 +93,27 @@ private:
     double k;           // Коэффициент усиления регулятора
     double tau;         // Запаздывание
     double dt;          // Шаг по времени
+    int delay_steps;    // Запаздывание в шагах, считается один раз
 
     // Состояния системы (с учетом запаздывания)
-    std::vector<double> x_history;      // История x(t)
-    std::vector<double> dx_history;     // История x'(t)
+    DelayLine x_delay;  // Последние delay_steps + 1 значений x(t)
+    double v;           // Текущее x'(t)
+    HistoryRecorder* recorder;  // Полная история, если нужна
 
 public:
-    DynamicSystem(double a0, double a1, double a2, double k, double tau, double dt)
-        : a0(a0), a1(a1), a2(a2), k(k), tau(tau), dt(dt) {
+    DynamicSystem(double a0, double a1, double a2, double k, double tau, double dt,
+        HistoryRecorder* recorder = nullptr)
+        : a0(a0), a1(a1), a2(a2), k(k), tau(tau), dt(dt),
+        delay_steps(delaySteps(tau, dt)), x_delay(delay_steps), v(0.0),
+        recorder(recorder) {
         // Инициализация начальных условий
-        x_history.push_back(0.0);
-        dx_history.push_back(0.0);
+        if (recorder) recorder->record(0.0, 0.0);
     }
 
     // Вычисление следующего состояния системы
     void step(double t) {
-        // Текущий индекс в истории
-        int current_idx = x_history.size() - 1;
-
-        // Определение индекса для запаздывающего состояния
-        int delay_steps = static_cast<int>(tau / dt);
-        int delayed_idx = std::max(0, current_idx - delay_steps);
-
         // Получение запаздывающего состояния
-        double x_delayed = x_history[delayed_idx];
+        double x_delayed = x_delay.delayed();
 
         // Вычисление управления (пропорциональный регулятор)
         double g = heaviside(t - tau);  // Цель с учетом запаздывания
@@ -50,93 +125,1049 @@ public:
         // x' = v
         // v' = (u - a1*v - a0*x) / a2
 
-        double x_prev = x_history[current_idx];
-        double v_prev = dx_history[current_idx];
+        double x_prev = x_delay.current();
+        double v_prev = v;
 
         double v_new = v_prev + dt * (u - a1 * v_prev - a0 * x_prev) / a2;
         double x_new = x_prev + dt * v_prev;
 
-        x_history.push_back(x_new);
-        dx_history.push_back(v_new);
+        x_delay.push(x_new);
+        v = v_new;
+        if (recorder) recorder->record(x_new, v_new);
     }
 
     // Получение текущего состояния
     double getCurrentState() const {
-        return x_history.back();
+        return x_delay.current();
     }
 
-    // Получение всей истории состояний
-    const std::vector<double>& getHistory() const {
-        return x_history;
+    // Сброс к начальным условиям (для нового моделирования)
+    void reset() {
+        x_delay.reset();
+        v = 0.0;
+        if (recorder) {
+            recorder->clear();
+            recorder->record(0.0, 0.0);
+        }
     }
+};
 
-    // Очистка истории (для нового моделирования)
-    void clearHistory() {
-        x_history.clear();
-        dx_history.clear();
-        x_history.push_back(0.0);
-        dx_history.push_back(0.0);
+// Линейный объект порядка N в пространстве состояний: x' = A*x + B*u, y = C*x.
+// Размер известен при компиляции, поэтому шаг - это полностью развернутые циклы
+// по std::array без кучи и без динамических циклов
+template <int N>
+struct StateSpace {
+    static_assert(N >= 1 && N <= 8, "StateSpace is meant for small orders");
+    typedef std::array<double, N> Vector;
+
+    std::array<Vector, N> A;
+    Vector B;
+    Vector C;
+
+    // Сопровождающая форма для a[N]*x^(N) + ... + a[1]*x' + a[0]*x = b*u, y = x
+    static StateSpace fromCoefficients(const std::array<double, N + 1>& a, double b = 1.0) {
+        StateSpace plant{};
+        for (int i = 0; i + 1 < N; ++i) plant.A[i][i + 1] = 1.0;
+        for (int j = 0; j < N; ++j) plant.A[N - 1][j] = -a[j] / a[N];
+        plant.B[N - 1] = b / a[N];
+        plant.C[0] = 1.0;
+        return plant;
+    }
+
+    double output(const Vector& x) const {
+        double y = 0.0;
+        for (int i = 0; i < N; ++i) y += C[i] * x[i];
+        return y;
+    }
+
+    // Шаг Эйлера: x += dt * (A*x + B*u)
+    void advance(Vector& x, double u, double dt) const {
+        Vector dx;
+        for (int i = 0; i < N; ++i) {
+            double sum = B[i] * u;
+            for (int j = 0; j < N; ++j) sum += A[i][j] * x[j];
+            dx[i] = sum;
+        }
+        for (int i = 0; i < N; ++i) x[i] += dt * dx[i];
+    }
+};
+
+typedef StateSpace<2> Plant2;
+typedef StateSpace<3> Plant3;
+typedef StateSpace<4> Plant4;
+
+// Регуляторы подключаются параметром шаблона (без виртуальных вызовов).
+// Интерфейс: double control(double reference, double measured)
+
+// Пропорциональный регулятор, как в DynamicSystem
+class PController {
+private:
+    double k;
+
+public:
+    explicit PController(double k) : k(k) {}
+
+    double control(double reference, double measured) {
+        return k * (reference - measured);
+    }
+};
+
+// ПИД-регулятор с производной по ошибке
+class PIDController {
+private:
+    double kp, ki, kd, dt;
+    double integral;
+    double prev_error;
+    bool first;
+
+public:
+    PIDController(double kp, double ki, double kd, double dt)
+        : kp(kp), ki(ki), kd(kd), dt(dt), integral(0.0), prev_error(0.0), first(true) {}
+
+    double control(double reference, double measured) {
+        double error = reference - measured;
+        integral += error * dt;
+        double derivative = first ? 0.0 : (error - prev_error) / dt;
+        prev_error = error;
+        first = false;
+        return kp * error + ki * integral + kd * derivative;
+    }
+};
+
+// Предиктор Смита: внутренний регулятор видит выход модели без запаздывания,
+// а измерение поправляется на разницу модели с запаздыванием и без него.
+// model_delay_steps - суммарное запаздывание контура (вход + измерение)
+template <int N, class Inner>
+class SmithPredictor {
+private:
+    Inner inner;
+    StateSpace<N> model;
+    typename StateSpace<N>::Vector x_model;
+    DelayLine model_output;
+    double dt;
+
+public:
+    SmithPredictor(const Inner& inner, const StateSpace<N>& model, int model_delay_steps, double dt)
+        : inner(inner), model(model), x_model{}, model_output(model_delay_steps), dt(dt) {}
+
+    double control(double reference, double measured) {
+        double y_model = model.output(x_model);
+        model_output.push(y_model);
+        double u = inner.control(reference, measured + y_model - model_output.delayed());
+        model.advance(x_model, u, dt);
+        return u;
+    }
+};
+
+// Замкнутый контур: объект порядка N, регулятор Controller,
+// запаздывание на входе объекта (исполнительное) и на измерении
+template <int N, class Controller>
+class DelayedLoop {
+private:
+    StateSpace<N> plant;
+    Controller controller;
+    typename StateSpace<N>::Vector x;
+    DelayLine input_delay;      // u(t - tau_u)
+    DelayLine output_delay;     // y(t - tau_y)
+    double dt;
+
+public:
+    static const int order = N;
+
+    DelayedLoop(const StateSpace<N>& plant, const Controller& controller,
+        double tau_u, double tau_y, double dt)
+        : plant(plant), controller(controller), x{},
+        input_delay(delaySteps(tau_u, dt)), output_delay(delaySteps(tau_y, dt)), dt(dt) {}
+
+    // Один шаг при задании reference; возвращает новый выход объекта
+    double step(double reference) {
+        output_delay.push(plant.output(x));
+        input_delay.push(controller.control(reference, output_delay.delayed()));
+        plant.advance(x, input_delay.delayed(), dt);
+        return plant.output(x);
+    }
+
+    double output() const {
+        return plant.output(x);
+    }
+};
+
+// Проверка обобщенного контура на исходной системе и пропускная способность
+// для порядков 2, 3, 4 с разными регуляторами. make(p) строит контур с объектом порядка N
+template <int N, class MakeLoop>
+void loopThroughput(const char* label, int plants, int steps, double dt, MakeLoop make) {
+    auto start = std::chrono::high_resolution_clock::now();
+    double checksum = 0.0;
+    for (int p = 0; p < plants; ++p) {
+        auto loop = make(p);
+        static_assert(decltype(loop)::order == N, "loop order does not match N");
+        for (int i = 0; i < steps; ++i) {
+            loop.step(heaviside(i * dt));
+        }
+        checksum += loop.output();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double sec = std::chrono::duration<double>(end - start).count();
+    std::cout << "  order " << N << ", " << label << ": " << plants * static_cast<double>(steps) / sec / 1e6
+        << " M steps/s (checksum " << checksum << ")" << std::endl;
+}
+
+void plantLibraryDemo(double a0, double a1, double a2, double k, double tau, double dt) {
+    // Порядок 2 с П-регулятором и запаздыванием измерения повторяет DynamicSystem
+    Plant2 plant2 = Plant2::fromCoefficients({ a0, a1, a2 });
+    DelayedLoop<2, PController> loop(plant2, PController(k), 0.0, tau, dt);
+    DynamicSystem system(a0, a1, a2, k, tau, dt);
+    double max_diff = 0.0;
+    int steps = static_cast<int>(20.0 / dt);
+    for (int i = 0; i < steps; ++i) {
+        double t = i * dt;
+        system.step(t);
+        double y = loop.step(heaviside(t - tau));
+        max_diff = std::max(max_diff, std::abs(y - system.getCurrentState()));
+    }
+    std::cout << "Order 2, P, tau = " << tau << ": max |y - DynamicSystem| = " << max_diff << std::endl;
+
+    Plant3 plant3 = Plant3::fromCoefficients({ 1.0, 3.0, 3.0, 1.0 });
+    Plant4 plant4 = Plant4::fromCoefficients({ 1.0, 4.0, 6.0, 4.0, 1.0 });
+    int plants = 2000;
+    std::cout << "Throughput (" << plants << " plants x " << steps << " steps):" << std::endl;
+    loopThroughput<2>("P", plants, steps, dt, [&](int p) {
+        return DelayedLoop<2, PController>(plant2, PController(0.5 + 0.001 * p), 0.0, tau, dt);
+    });
+    loopThroughput<2>("PID", plants, steps, dt, [&](int p) {
+        return DelayedLoop<2, PIDController>(plant2, PIDController(0.5 + 0.001 * p, 0.3, 0.1, dt), 0.2, tau, dt);
+    });
+    loopThroughput<3>("PID", plants, steps, dt, [&](int p) {
+        return DelayedLoop<3, PIDController>(plant3, PIDController(0.5 + 0.001 * p, 0.3, 0.1, dt), 0.2, tau, dt);
+    });
+    loopThroughput<4>("Smith + PID", plants, steps, dt, [&](int p) {
+        typedef SmithPredictor<4, PIDController> Smith;
+        Smith smith(PIDController(0.5 + 0.001 * p, 0.3, 0.1, dt), plant4, delaySteps(0.2 + tau, dt), dt);
+        return DelayedLoop<4, Smith>(plant4, smith, 0.2, tau, dt);
+    });
+}
+
+// Объект с запаздыванием в общем виде для интеграторов:
+// a2*x'' + a1*x' + a0*x = k*(g(t - tau) - x(t - tau))
+struct DelayPlant {
+    double a0, a1, a2, k, tau;
+
+    // x'' при известном запаздывающем x и цели g на шаге
+    double accel(double x, double v, double x_delayed, double g) const {
+        double u = k * (g - x_delayed);
+        return (u - a1 * v - a0 * x) / a2;
+    }
+};
+
+// История решения для запаздывающего состояния в произвольный момент.
+// Между узлами - кубический эрмитов сплайн по x и x', поэтому tau не обязано
+// быть кратно шагу. Хранится только отрезок длины tau, память O(задержки)
+class HermiteHistory {
+private:
+    struct Sample {
+        double t, x, v;
+    };
+    std::deque<Sample> samples;
+    double span;        // Сколько хранить назад (tau)
+
+public:
+    explicit HermiteHistory(double span) : span(span) {
+        samples.push_back({ 0.0, 0.0, 0.0 });
+    }
+
+    void push(double t, double x, double v) {
+        samples.push_back({ t, x, v });
+        // Оставляем один узел левее t - span, он нужен для интерполяции
+        while (samples.size() > 2 && samples[1].t <= t - span) {
+            samples.pop_front();
+        }
+    }
+
+    // x(t); до начала моделирования система в покое
+    double at(double t) const {
+        if (t <= samples.front().t) return samples.front().x;
+        if (t >= samples.back().t) return samples.back().x;
+        auto it = std::lower_bound(samples.begin(), samples.end(), t,
+            [](const Sample& sample, double value) { return sample.t < value; });
+        const Sample& p0 = *(it - 1);
+        const Sample& p1 = *it;
+        double h = p1.t - p0.t;
+        double s = (t - p0.t) / h;
+        double s2 = s * s, s3 = s2 * s;
+        return (2 * s3 - 3 * s2 + 1) * p0.x + (s3 - 2 * s2 + s) * h * p0.v
+            + (-2 * s3 + 3 * s2) * p1.x + (s3 - s2) * h * p1.v;
+    }
+
+    size_t size() const {
+        return samples.size();
+    }
+};
+
+// Текущее состояние решения и счетчики стоимости
+struct DelayState {
+    double t = 0.0, x = 0.0, v = 0.0;
+    HermiteHistory history;
+    long long steps = 0;        // Принятые шаги
+    long long evaluations = 0;  // Вычисления правой части
+
+    explicit DelayState(double tau) : history(tau) {}
+};
+
+// Общий интерфейс интеграторов. Цель g(t - tau) разрывна в t = tau,
+// поэтому на шаге она постоянна и берется в его середине
+class Integrator {
+public:
+    virtual ~Integrator() {}
+
+    // Продвинуть решение до момента t_end
+    virtual void advance(const DelayPlant& plant, DelayState& s, double t_end) = 0;
+
+    virtual std::string name() const = 0;
+
+protected:
+    // Запаздывающее x в момент t; при tau = 0 это текущее значение стадии
+    static double delayed(const DelayPlant& plant, const DelayState& s, double t, double x_now) {
+        return plant.tau > 0 ? s.history.at(t - plant.tau) : x_now;
+    }
+
+    // Сколько шагов не длиннее h уложить до t_end (шаг подгоняется, чтобы попасть ровно в t_end)
+    static int fixedSteps(const DelayState& s, double h, double t_end) {
+        return static_cast<int>(std::ceil((t_end - s.t) / h - 1e-6));
+    }
+
+    static void accept(DelayState& s, double t, double x, double v) {
+        s.t = t;
+        s.x = x;
+        s.v = v;
+        s.history.push(s.t, x, v);
+        s.steps++;
+    }
+};
+
+// Явный метод Эйлера с постоянным шагом, как в DynamicSystem
+class EulerIntegrator : public Integrator {
+private:
+    double h;
+
+public:
+    explicit EulerIntegrator(double h) : h(h) {}
+
+    void advance(const DelayPlant& plant, DelayState& s, double t_end) override {
+        int n = fixedSteps(s, h, t_end);
+        double t0 = s.t;
+        double step = (t_end - t0) / n;
+        for (int i = 0; i < n; ++i) {
+            double g = heaviside(s.t + step / 2 - plant.tau);
+            double a = plant.accel(s.x, s.v, delayed(plant, s, s.t, s.x), g);
+            s.evaluations++;
+            accept(s, t0 + (i + 1) * step, s.x + step * s.v, s.v + step * a);
+        }
+    }
+
+    std::string name() const override {
+        return "Euler h=" + std::to_string(h);
+    }
+};
+
+// Классический Рунге-Кутта 4-го порядка с постоянным шагом. Как и у адаптивного
+// метода, шаг не длиннее tau и не перешагивает разрыв цели в t = tau: иначе
+// стадии берут разрывную цель и еще не посчитанную историю, и порядок теряется
+class RK4Integrator : public Integrator {
+private:
+    double h;
+
+public:
+    explicit RK4Integrator(double h) : h(h) {}
+
+    void advance(const DelayPlant& plant, DelayState& s, double t_end) override {
+        double h_max = plant.tau > 0 ? std::min(h, plant.tau) : h;
+        while (s.t < t_end - 1e-12) {
+            double t_stop = t_end;
+            if (s.t < plant.tau - 1e-12 && plant.tau < t_end) t_stop = plant.tau;
+            int n = std::max(1, fixedSteps(s, h_max, t_stop));
+            double t0 = s.t;
+            double step = (t_stop - t0) / n;
+            for (int i = 0; i < n; ++i) {
+                double t = s.t, x = s.x, v = s.v;
+                double g = heaviside(t + step / 2 - plant.tau);
+
+                double x1 = x, v1 = v;
+                double a1 = plant.accel(x1, v1, delayed(plant, s, t, x1), g);
+                double x2 = x + step / 2 * v1, v2 = v + step / 2 * a1;
+                double a2 = plant.accel(x2, v2, delayed(plant, s, t + step / 2, x2), g);
+                double x3 = x + step / 2 * v2, v3 = v + step / 2 * a2;
+                double a3 = plant.accel(x3, v3, delayed(plant, s, t + step / 2, x3), g);
+                double x4 = x + step * v3, v4 = v + step * a3;
+                double a4 = plant.accel(x4, v4, delayed(plant, s, t + step, x4), g);
+                s.evaluations += 4;
+
+                accept(s, i + 1 == n ? t_stop : t0 + (i + 1) * step,
+                    x + step / 6 * (v1 + 2 * v2 + 2 * v3 + v4),
+                    v + step / 6 * (a1 + 2 * a2 + 2 * a3 + a4));
+            }
+        }
+    }
+
+    std::string name() const override {
+        return "RK4 h=" + std::to_string(h);
+    }
+};
+
+// Адаптивный шаг: пара Богацкого-Шампайна 3(2) с контролем локальной ошибки.
+// Шаг не длиннее tau (запаздывающие стадии берутся из уже посчитанной истории)
+// и не перешагивает разрыв цели в t = tau
+class AdaptiveIntegrator : public Integrator {
+private:
+    double rtol, atol;
+    double h;           // Текущий шаг, переносится между вызовами
+    double h_max;
+
+public:
+    AdaptiveIntegrator(double rtol, double atol, double h_max = 0.5)
+        : rtol(rtol), atol(atol), h(1e-3), h_max(h_max) {}
+
+    void advance(const DelayPlant& plant, DelayState& s, double t_end) override {
+        while (s.t < t_end - 1e-12) {
+            double step = std::min(h, t_end - s.t);
+            if (plant.tau > 0) {
+                step = std::min(step, plant.tau);
+                if (s.t < plant.tau && s.t + step > plant.tau) step = plant.tau - s.t;
+            }
+            double t = s.t, x = s.x, v = s.v;
+            double g = heaviside(t + step / 2 - plant.tau);
+
+            double a1 = plant.accel(x, v, delayed(plant, s, t, x), g);
+            double x2 = x + step / 2 * v, v2 = v + step / 2 * a1;
+            double a2 = plant.accel(x2, v2, delayed(plant, s, t + step / 2, x2), g);
+            double x3 = x + step * 3 / 4 * v2, v3 = v + step * 3 / 4 * a2;
+            double a3 = plant.accel(x3, v3, delayed(plant, s, t + step * 3 / 4, x3), g);
+            double x_new = x + step * (2.0 / 9 * v + 1.0 / 3 * v2 + 4.0 / 9 * v3);
+            double v_new = v + step * (2.0 / 9 * a1 + 1.0 / 3 * a2 + 4.0 / 9 * a3);
+            double a4 = plant.accel(x_new, v_new, delayed(plant, s, t + step, x_new), g);
+            s.evaluations += 4;
+
+            // Разность решений 3-го и 2-го порядка
+            double ex = step * (-5.0 / 72 * v + 1.0 / 12 * v2 + 1.0 / 9 * v3 - 1.0 / 8 * v_new);
+            double ev = step * (-5.0 / 72 * a1 + 1.0 / 12 * a2 + 1.0 / 9 * a3 - 1.0 / 8 * a4);
+            double err = std::max(
+                std::abs(ex) / (atol + rtol * std::max(std::abs(x), std::abs(x_new))),
+                std::abs(ev) / (atol + rtol * std::max(std::abs(v), std::abs(v_new))));
+
+            double factor = err > 0 ? 0.9 * std::pow(err, -1.0 / 3) : 5.0;
+            factor = std::min(5.0, std::max(0.2, factor));
+            if (err <= 1.0) {
+                accept(s, t + step, x_new, v_new);
+                h = std::min(h_max, step * factor);
+            }
+            else {
+                h = step * factor;
+            }
+        }
+    }
+
+    std::string name() const override {
+        return "Adaptive rtol=" + std::to_string(rtol);
     }
 };
 
+// Точность и стоимость интеграторов относительно эталона (RK4 с очень мелким шагом).
+// Ошибка - максимум |x - x_ref| по моментам 0.1, 0.2, ..., simulation_time
+void integratorAccuracy(double a0, double a1, double a2, double k, double tau,
+    double simulation_time) {
+    DelayPlant plant{ a0, a1, a2, k, tau };
+    const double out_dt = 0.1;
+    int outputs = static_cast<int>(simulation_time / out_dt + 0.5);
+
+    auto run = [&](Integrator& integrator, std::vector<double>& xs, DelayState& s) {
+        xs.clear();
+        for (int i = 1; i <= outputs; ++i) {
+            integrator.advance(plant, s, i * out_dt);
+            xs.push_back(s.x);
+        }
+    };
+
+    std::vector<double> reference;
+    RK4Integrator fine(1e-4);
+    DelayState ref_state(tau);
+    run(fine, reference, ref_state);
+
+    EulerIntegrator euler(0.01), euler_fine(0.001);
+    RK4Integrator rk4_1(0.1), rk4_05(0.05), rk4_01(0.01);
+    AdaptiveIntegrator adaptive_4(1e-4, 1e-6), adaptive_6(1e-6, 1e-8);
+    Integrator* methods[] = { &euler, &euler_fine, &rk4_1, &rk4_05, &rk4_01, &adaptive_4, &adaptive_6 };
+
+    std::cout << "tau = " << tau << " (reference: " << ref_state.steps << " RK4 steps)" << std::endl;
+    for (Integrator* method : methods) {
+        DelayState s(tau);
+        std::vector<double> xs;
+        auto start = std::chrono::high_resolution_clock::now();
+        run(*method, xs, s);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double max_error = 0.0;
+        for (size_t i = 0; i < xs.size(); ++i) {
+            max_error = std::max(max_error, std::abs(xs[i] - reference[i]));
+        }
+        std::cout << "  " << method->name() << ": error = " << max_error
+            << ", steps = " << s.steps << ", evaluations = " << s.evaluations
+            << ", time = " << std::chrono::duration<double, std::micro>(end - start).count() << " us"
+            << std::endl;
+    }
+}
+
+// Одна точка пространства параметров для анализа устойчивости
+struct StabilityConfig {
+    double tau, k, a0, a1, a2;
+};
+
+struct StabilityResult {
+    bool is_stable;
+    double max_overshoot;
+    double settling_time;
+    int steps;          // Сколько шагов понадобилось до решения
+};
+
+// Установившееся значение x_ss = k / (a0 + k) для П-регулятора
+double steadyState(double a0, double k) {
+    return std::abs(a0 + k) > 1e-12 ? k / (a0 + k) : 1.0;
+}
+
+const int BATCH = 64;
+
+// Потоковый классификатор траекторий пачки. Огибающая - пики |x - x_ss| на полупериодах
+// (между сменами знака отклонения). Если пики растут несколько полупериодов подряд -
+// траектория разошлась; если отклонение держится ниже порога целое окно длиной
+// в запаздывание, а пики не растут - сошлась. В обоих случаях моделирование
+// можно остановить. Время установления - момент после последнего выхода
+// из 2% полосы вокруг установившегося значения x_ss, а не первый вход в нее.
+// Поля лежат плоскими массивами по конфигурациям, шаг считается выбором значений без ветвлений
+struct StabilityLanes {
+    double target[BATCH];      // Установившееся значение
+    double band[BATCH];        // Полуширина 2% полосы
+    int window[BATCH];         // Окно сходимости в шагах (не короче запаздывания)
+    int quiet[BATCH];          // Сколько шагов подряд отклонение ниже порога
+    int sign[BATCH];           // Знак отклонения на текущем полупериоде
+    double peak[BATCH];        // Пик текущего полупериода
+    double prev_peak[BATCH];   // Пик прошлого полупериода
+    int growing[BATCH];        // Сколько полупериодов подряд пик растет
+    double last_exit[BATCH];   // Момент после последнего выхода из полосы
+    int outside[BATCH];
+    double max_overshoot[BATCH];
+    int decision[BATCH];       // 0 - не решено, 1 - сошлась, -1 - разошлась
+    int steps[BATCH];
+
+    void reset(int j, double x_ss, double dt, int delay_steps) {
+        target[j] = x_ss;
+        band[j] = 0.02 * std::max(std::abs(x_ss), 1e-9);
+        window[j] = std::max(delay_steps, static_cast<int>(1.0 / dt));
+        quiet[j] = sign[j] = growing[j] = outside[j] = decision[j] = steps[j] = 0;
+        peak[j] = 0.0;
+        prev_peak[j] = std::numeric_limits<double>::infinity();
+        last_exit[j] = 0.0;
+        max_overshoot[j] = 0.0;
+    }
+
+    // Перенос конфигурации from на место to (уплотнение пачки)
+    void move(int from, int to) {
+        target[to] = target[from];
+        band[to] = band[from];
+        window[to] = window[from];
+        quiet[to] = quiet[from];
+        sign[to] = sign[from];
+        peak[to] = peak[from];
+        prev_peak[to] = prev_peak[from];
+        growing[to] = growing[from];
+        last_exit[to] = last_exit[from];
+        outside[to] = outside[from];
+        max_overshoot[to] = max_overshoot[from];
+        decision[to] = decision[from];
+        steps[to] = steps[from];
+    }
+
+    // Учесть очередные состояния x первых count конфигураций (все еще не решены);
+    // возвращает, сколько из них остались нерешенными
+    int update(double t, double dt, const double* x, int count) {
+        int alive = 0;
+        for (int j = 0; j < count; ++j) {
+            double deviation = x[j] - target[j];
+            double magnitude = std::abs(deviation);
+            // Перерегулирование - выход за x_ss в сторону движения, в долях |x_ss|
+            double overshoot = (target[j] < 0 ? -deviation : deviation) / std::max(std::abs(target[j]), 1e-9);
+            max_overshoot[j] = std::max(max_overshoot[j], overshoot);
+            outside[j] = magnitude > band[j];
+            last_exit[j] = outside[j] ? t + dt : last_exit[j];
+            // Не конечное (NaN не проходит сравнение) или огромное отклонение - разошлась
+            int blown = !(magnitude <= 1e6 * (1.0 + std::abs(target[j])));
+
+            // Смена знака закрывает полупериод
+            int s = deviation > 0 ? 1 : (deviation < 0 ? -1 : sign[j]);
+            int flip = (sign[j] != 0) & (s != sign[j]);
+            int grown = (peak[j] > prev_peak[j]) & (peak[j] > band[j]) ? growing[j] + 1 : 0;
+            growing[j] = flip ? grown : growing[j];
+            prev_peak[j] = flip ? peak[j] : prev_peak[j];
+            peak[j] = std::max(flip ? 0.0 : peak[j], magnitude);
+            sign[j] = s;
+
+            quiet[j] = magnitude < 0.1 * band[j] ? quiet[j] + 1 : 0;
+            int diverged = blown | (flip & (growing[j] >= 3));
+            int converged = (quiet[j] >= window[j]) & (growing[j] == 0);
+            decision[j] = diverged ? -1 : converged;
+            steps[j]++;
+            alive += decision[j] == 0;
+        }
+        return alive;
+    }
+
+    // Если до конца моделирования исход не решен, смотрим, затухает ли огибающая
+    bool isStable(int j) const {
+        if (decision[j] != 0) return decision[j] > 0;
+        if (growing[j] > 0) return false;
+        return peak[j] <= std::min(prev_peak[j], std::max(std::abs(target[j]), band[j]));
+    }
+
+    double settlingTime(int j, double simulation_time) const {
+        if (!isStable(j) || outside[j]) return simulation_time;
+        return last_exit[j];
+    }
+};
+
+// Пачечный движок: BATCH конфигураций идут одновременно по одной сетке времени.
+// Состояние хранится массивами по конфигурациям (SoA), линии задержки разной длины
+// лежат в одном буфере со своим смещением. Шаг тот же, что в DynamicSystem::step.
+// Чтение и запись линий задержки (разрозненные адреса) вынесены из арифметики шага,
+// так что сам шаг - цикл без ветвлений по массивам, который векторизуется.
+// Решенные конфигурации не маскируются, а убираются: оставшиеся сдвигаются в начало
+// пачки, и дальше считаются только первые alive
+void simulateStabilityBatch(const StabilityConfig* configs, StabilityResult* results, int count,
+    double dt, double simulation_time) {
+    double x[BATCH], v[BATCH], x_delayed[BATCH];
+    double tau[BATCH], k[BATCH], a0[BATCH], a1[BATCH], a2[BATCH];
+    int head[BATCH], capacity[BATCH], offset[BATCH];
+    int id[BATCH];      // Номер конфигурации на этом месте пачки
+    StabilityLanes lanes;
+
+    int total = 0;
+    for (int j = 0; j < count; ++j) {
+        const StabilityConfig& c = configs[j];
+        tau[j] = c.tau; k[j] = c.k; a0[j] = c.a0; a1[j] = c.a1; a2[j] = c.a2;
+        x[j] = v[j] = 0.0;
+        capacity[j] = delaySteps(c.tau, dt) + 1;
+        offset[j] = total;
+        head[j] = 0;
+        id[j] = j;
+        total += capacity[j];
+        lanes.reset(j, steadyState(c.a0, c.k), dt, capacity[j] - 1);
+    }
+    std::vector<double> buffer(total, 0.0);  // Все линии задержки пачки
+
+    auto finish = [&](int j) {
+        StabilityResult& r = results[id[j]];
+        r.is_stable = lanes.isStable(j);
+        r.max_overshoot = lanes.max_overshoot[j];
+        r.settling_time = lanes.settlingTime(j, simulation_time);
+        r.steps = lanes.steps[j];
+    };
+
+    int steps = static_cast<int>(simulation_time / dt);
+    int alive = count;
+    for (int i = 0; i < steps && alive > 0; ++i) {
+        double t = i * dt;
+        for (int j = 0; j < alive; ++j) {
+            head[j] = head[j] + 1 == capacity[j] ? 0 : head[j] + 1;  // Самое старое значение
+            x_delayed[j] = buffer[offset[j] + head[j]];
+        }
+        for (int j = 0; j < alive; ++j) {
+            double u = k[j] * (heaviside(t - tau[j]) - x_delayed[j]);
+            double x_new = x[j] + dt * v[j];
+            v[j] = v[j] + dt * (u - a1[j] * v[j] - a0[j] * x[j]) / a2[j];
+            x[j] = x_new;
+        }
+        for (int j = 0; j < alive; ++j) {
+            buffer[offset[j] + head[j]] = x[j];
+        }
+
+        int undecided = lanes.update(t, dt, x, alive);
+        if (undecided == alive) continue;
+        int kept = 0;
+        for (int j = 0; j < alive; ++j) {
+            if (lanes.decision[j] != 0) {
+                finish(j);
+                continue;
+            }
+            if (kept != j) {
+                tau[kept] = tau[j]; k[kept] = k[j]; a0[kept] = a0[j]; a1[kept] = a1[j]; a2[kept] = a2[j];
+                x[kept] = x[j]; v[kept] = v[j];
+                head[kept] = head[j]; capacity[kept] = capacity[j]; offset[kept] = offset[j];
+                id[kept] = id[j];
+                lanes.move(j, kept);
+            }
+            kept++;
+        }
+        alive = kept;
+    }
+
+    for (int j = 0; j < alive; ++j) finish(j);
+}
+
+// Средняя доля шагов, которые реально пришлось посчитать
+double averageStepFraction(const std::vector<StabilityResult>& results, double dt, double simulation_time) {
+    double full = simulation_time / dt;
+    double sum = 0.0;
+    for (const auto& r : results) sum += r.steps / full;
+    return results.empty() ? 0.0 : sum / results.size();
+}
+
+// Раздача пачек по потокам
+std::vector<StabilityResult> simulateStability(const std::vector<StabilityConfig>& configs,
+    double dt, double simulation_time) {
+    std::vector<StabilityResult> results(configs.size());
+    int batches = static_cast<int>((configs.size() + BATCH - 1) / BATCH);
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int b = next++; b < batches; b = next++) {
+            int first = b * BATCH;
+            int count = std::min(BATCH, static_cast<int>(configs.size()) - first);
+            simulateStabilityBatch(&configs[first], &results[first], count, dt, simulation_time);
+        }
+    };
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads && i < batches; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+    return results;
+}
+
+// Число точек сетки от min до max с шагом step (по индексу, без накопления ошибки)
+int gridPoints(double min, double max, double step) {
+    return static_cast<int>(std::floor((max - min) / step + 1e-9)) + 1;
+}
+
 // Функция для исследования устойчивости системы
 void stabilityAnalysis(double a0, double a1, double a2, double k,
     double tau_min, double tau_max, double tau_step,
     double dt, double simulation_time) {
 
+    std::vector<StabilityConfig> configs;
+    int points = gridPoints(tau_min, tau_max, tau_step);
+    for (int i = 0; i < points; ++i) {
+        configs.push_back({ tau_min + i * tau_step, k, a0, a1, a2 });
+    }
+    std::vector<StabilityResult> results = simulateStability(configs, dt, simulation_time);
+
     std::ofstream output("stability_analysis.txt");
     output << "tau,is_stable,max_overshoot,settling_time\n";
 
-    for (double tau = tau_min; tau <= tau_max; tau += tau_step) {
-        DynamicSystem system(a0, a1, a2, k, tau, dt);
+    for (size_t i = 0; i < configs.size(); ++i) {
+        double tau = configs[i].tau;
+        const StabilityResult& r = results[i];
 
-        // Моделирование системы
-        int steps = static_cast<int>(simulation_time / dt);
-        double max_overshoot = 0.0;
-        double settling_time = simulation_time;
-        bool is_stable = true;
+        output << tau << " " << (r.is_stable ? 1 : 0) << " "
+            << r.max_overshoot << " " << r.settling_time << "\n";
 
-        for (int i = 0; i < steps; ++i) {
-            double t = i * dt;
-            system.step(t);
+        std::cout << "tau = " << tau << ": " << (r.is_stable ? "Stable" : "Unstable")
+            << ", Max overshoot = " << r.max_overshoot
+            << ", Settling time = " << r.settling_time << std::endl;
+    }
+
+    output.close();
+}
 
-            double current_state = system.getCurrentState();
+// Карта устойчивости на плотной сетке (k, tau): те же столбцы, что в stability_analysis.txt,
+// плюс коэффициент усиления
+void stabilityGrid(double a0, double a1, double a2,
+    double k_min, double k_max, double k_step,
+    double tau_min, double tau_max, double tau_step,
+    double dt, double simulation_time, const std::string& filename) {
 
-            // Проверка на устойчивость (расходимость)
-            if (std::abs(current_state) > 1.0) {
-                is_stable = false;
-                break;
-            }
+    std::vector<StabilityConfig> configs;
+    int k_points = gridPoints(k_min, k_max, k_step);
+    int tau_points = gridPoints(tau_min, tau_max, tau_step);
+    for (int i = 0; i < k_points; ++i) {
+        for (int j = 0; j < tau_points; ++j) {
+            configs.push_back({ tau_min + j * tau_step, k_min + i * k_step, a0, a1, a2 });
+        }
+    }
 
-            // Определение максимального перерегулирования
-            if (std::abs(current_state - 1.0) > max_overshoot) {
-                max_overshoot = std::abs(current_state - 1.0);
-            }
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<StabilityResult> results = simulateStability(configs, dt, simulation_time);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::ofstream output(filename);
+    output << "k,tau,is_stable,max_overshoot,settling_time\n";
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const StabilityResult& r = results[i];
+        output << configs[i].k << " " << configs[i].tau << " " << (r.is_stable ? 1 : 0) << " "
+            << r.max_overshoot << " " << r.settling_time << "\n";
+    }
+    output.close();
+
+    std::cout << configs.size() << " configurations in "
+        << std::chrono::duration<double>(end - start).count() << " s, "
+        << 100 * averageStepFraction(results, dt, simulation_time) << "% of steps simulated" << std::endl;
+}
 
-            // Определение времени установления (в пределах 2% от установившегося значения)
-            if (is_stable && std::abs(current_state - 1.0) < 0.02 && t < settling_time) {
-                settling_time = t;
+// Аналитическая устойчивость по характеристическому квазиполиному
+// a2*s^2 + a1*s + a0 + k*e^(-s*tau) = 0 (метод частот пересечения).
+// Корень на мнимой оси s = i*w возможен только при |P(iw)| = |k|, P(s) = a2*s^2 + a1*s + a0:
+// (a0 - a2*w^2)^2 + a1^2*w^2 = k^2 - квадратное уравнение относительно W = w^2.
+// Для каждой частоты запаздывания пересечения образуют арифметическую прогрессию,
+// направление пересечения задает знак F'(W), F(W) = |P(iw)|^2 - k^2
+struct DelayStability {
+    double tau_critical;    // Первая потеря устойчивости (0 - неустойчива уже без запаздывания, inf - никогда)
+    std::vector<std::pair<double, double>> stable;  // Интервалы устойчивости по tau в [0, tau_max] (концы - пересечения)
+};
+
+// Число корней с Re > 0 при tau = 0: a2*s^2 + a1*s + (a0 + k)
+int unstableRootsWithoutDelay(double a0, double a1, double a2, double k) {
+    std::complex<double> disc = std::sqrt(std::complex<double>(a1 * a1 - 4 * a2 * (a0 + k)));
+    std::complex<double> roots[2] = { (-a1 + disc) / (2 * a2), (-a1 - disc) / (2 * a2) };
+    int count = 0;
+    for (const auto& root : roots) {
+        if (root.real() > 0) count++;
+    }
+    return count;
+}
+
+DelayStability delayStability(double a0, double a1, double a2, double k, double tau_max) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double pi = std::acos(-1.0);
+
+    // Пересечения мнимой оси: (tau, +2 - пара корней уходит вправо, -2 - возвращается)
+    std::vector<std::pair<double, int>> crossings;
+    double A = a2 * a2;
+    double B = a1 * a1 - 2 * a0 * a2;
+    double C = a0 * a0 - k * k;
+    double D = B * B - 4 * A * C;
+    if (k != 0 && D >= 0) {
+        double Ws[2] = { (-B + std::sqrt(D)) / (2 * A), (-B - std::sqrt(D)) / (2 * A) };
+        for (int r = 0; r < (D > 0 ? 2 : 1); ++r) {
+            double W = Ws[r];
+            if (W <= 0) continue;
+            double slope = 2 * A * W + B;  // F'(W)
+            if (slope == 0) continue;       // Касание без пересечения
+            double w = std::sqrt(W);
+            // k*e^(-iwt) = -P(iw)  =>  w*tau = -arg(-P(iw)/k) (mod 2*pi)
+            std::complex<double> P(a0 - a2 * W, a1 * w);
+            double theta = -std::arg(-P / k);
+            if (theta < 0) theta += 2 * pi;
+            for (double tau = theta / w; tau <= tau_max; tau += 2 * pi / w) {
+                crossings.push_back({ tau, slope > 0 ? 2 : -2 });
             }
         }
+    }
+    std::sort(crossings.begin(), crossings.end());
 
-        output << tau << " " << (is_stable ? 1 : 0) << " "
-            << max_overshoot << " " << settling_time << "\n";
+    DelayStability result;
+    result.tau_critical = inf;
+    int unstable = unstableRootsWithoutDelay(a0, a1, a2, k);
+    double start = 0.0;
+    if (unstable > 0) result.tau_critical = 0.0;
+    for (const auto& crossing : crossings) {
+        int before = unstable;
+        unstable = std::max(0, unstable + crossing.second);
+        if (before == 0 && unstable > 0) {
+            if (crossing.first > start) result.stable.push_back({ start, crossing.first });
+            if (result.tau_critical == inf) result.tau_critical = crossing.first;
+        }
+        if (before > 0 && unstable == 0) start = crossing.first;
+    }
+    if (unstable == 0) result.stable.push_back({ start, tau_max });
+    return result;
+}
+
+bool isStableAt(const DelayStability& stability, double tau) {
+    for (const auto& interval : stability.stable) {
+        if (tau >= interval.first && tau <= interval.second) return true;
+    }
+    return false;
+}
 
-        std::cout << "tau = " << tau << ": " << (is_stable ? "Stable" : "Unstable")
-            << ", Max overshoot = " << max_overshoot
-            << ", Settling time = " << settling_time << std::endl;
+// Граница устойчивости на плоскости (k, tau) и сверка с моделированием на той же сетке
+void stabilityBoundary(double a0, double a1, double a2,
+    double k_min, double k_max, double k_step,
+    double tau_min, double tau_max, double tau_step,
+    double dt, double simulation_time, const std::string& filename) {
+
+    int k_points = gridPoints(k_min, k_max, k_step);
+    int tau_points = gridPoints(tau_min, tau_max, tau_step);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<DelayStability> analytic;
+    for (int i = 0; i < k_points; ++i) {
+        analytic.push_back(delayStability(a0, a1, a2, k_min + i * k_step, tau_max));
     }
+    auto analytic_end = std::chrono::high_resolution_clock::now();
 
+    std::ofstream output(filename);
+    output << "k,tau_critical,stable_intervals\n";
+    for (int i = 0; i < k_points; ++i) {
+        output << k_min + i * k_step << " " << analytic[i].tau_critical;
+        for (const auto& interval : analytic[i].stable) {
+            output << " [" << interval.first << "," << interval.second << ")";
+        }
+        output << "\n";
+    }
     output.close();
+
+    std::vector<StabilityConfig> configs;
+    for (int i = 0; i < k_points; ++i) {
+        for (int j = 0; j < tau_points; ++j) {
+            configs.push_back({ tau_min + j * tau_step, k_min + i * k_step, a0, a1, a2 });
+        }
+    }
+    auto sim_start = std::chrono::high_resolution_clock::now();
+    std::vector<StabilityResult> simulated = simulateStability(configs, dt, simulation_time);
+    auto sim_end = std::chrono::high_resolution_clock::now();
+
+    int agree = 0, only_analytic = 0, only_simulated = 0;
+    for (size_t n = 0; n < configs.size(); ++n) {
+        bool expected = isStableAt(analytic[n / tau_points], configs[n].tau);
+        if (expected == simulated[n].is_stable) agree++;
+        else if (expected) only_analytic++;
+        else only_simulated++;
+    }
+
+    std::cout << "Analytic: " << k_points << " gains in "
+        << std::chrono::duration<double, std::micro>(analytic_end - start).count() << " us" << std::endl;
+    std::cout << "Simulation: " << configs.size() << " points in "
+        << std::chrono::duration<double>(sim_end - sim_start).count() << " s, "
+        << 100 * averageStepFraction(simulated, dt, simulation_time) << "% of steps simulated" << std::endl;
+    std::cout << "Agree: " << agree << ", stable only analytically: " << only_analytic
+        << ", stable only in simulation: " << only_simulated << std::endl;
 }
 
+// Буферизованная запись трасс. Текст форматируется через std::to_chars (как "%g",
+// без локали и потоков), бинарный вариант пишет блоки по столбцам:
+// "TRC1", число столбцов, имена через '\0', затем блоки [строк в блоке, столбец 0, столбец 1, ...].
+// Для графиков можно прореживать (каждая factor-я строка) или сворачивать
+// каждые factor строк в две: поэлементные минимум и максимум
+class TraceSink {
+public:
+    enum class Format { Text, Binary };
+    enum class Reduce { None, Decimate, MinMax };
+
+private:
+    std::FILE* file;
+    Format format;
+    Reduce reduce;
+    int factor;
+    size_t columns;
+    std::vector<char> text;             // Текстовый буфер
+    std::vector<double> block;          // Бинарный блок: строки подряд, транспонируются при сбросе
+    std::vector<double> low, high;      // Минимум и максимум текущей группы
+    long long rows_seen;
+    static const size_t buffer_size = 1 << 16;
+    static const size_t block_rows = 4096;
+
+    void emit(const double* row) {
+        if (format == Format::Binary) {
+            block.insert(block.end(), row, row + columns);
+            if (block.size() >= block_rows * columns) flushBinary();
+            return;
+        }
+        for (size_t c = 0; c < columns; ++c) {
+            char buf[32];
+            auto res = std::to_chars(buf, buf + sizeof(buf), row[c], std::chars_format::general, 6);
+            text.insert(text.end(), buf, res.ptr);
+            text.push_back(c + 1 < columns ? ' ' : '\n');
+        }
+        if (text.size() >= buffer_size) flushText();
+    }
+
+    void flushText() {
+        std::fwrite(text.data(), 1, text.size(), file);
+        text.clear();
+    }
+
+    void flushBinary() {
+        uint32_t rows = static_cast<uint32_t>(block.size() / columns);
+        if (rows == 0) return;
+        std::fwrite(&rows, sizeof(rows), 1, file);
+        std::vector<double> column(rows);
+        for (size_t c = 0; c < columns; ++c) {
+            for (uint32_t r = 0; r < rows; ++r) column[r] = block[r * columns + c];
+            std::fwrite(column.data(), sizeof(double), rows, file);
+        }
+        block.clear();
+    }
+
+    void flushGroup() {
+        if (rows_seen % factor == 0) return;
+        emit(low.data());
+        emit(high.data());
+    }
+
+public:
+    TraceSink(const std::string& filename, const std::vector<std::string>& names,
+        Format format = Format::Text, Reduce reduce = Reduce::None, int factor = 1)
+        : file(std::fopen(filename.c_str(), format == Format::Binary ? "wb" : "w")),
+        format(format), reduce(reduce), factor(std::max(1, factor)), columns(names.size()),
+        low(names.size()), high(names.size()), rows_seen(0) {
+        if (!file) throw std::runtime_error("Cannot open " + filename);
+        if (format == Format::Binary) {
+            uint32_t count = static_cast<uint32_t>(columns);
+            std::fwrite("TRC1", 1, 4, file);
+            std::fwrite(&count, sizeof(count), 1, file);
+            for (const auto& name : names) std::fwrite(name.c_str(), 1, name.size() + 1, file);
+        }
+        else {
+            std::string header;
+            for (size_t c = 0; c < names.size(); ++c) header += (c ? "," : "") + names[c];
+            header += "\n";
+            text.insert(text.end(), header.begin(), header.end());
+        }
+    }
+
+    TraceSink(const TraceSink&) = delete;
+    TraceSink& operator=(const TraceSink&) = delete;
+
+    ~TraceSink() {
+        close();
+    }
+
+    // Строка из columns значений
+    void write(const double* row) {
+        switch (reduce) {
+        case Reduce::None:
+            emit(row);
+            break;
+        case Reduce::Decimate:
+            if (rows_seen % factor == 0) emit(row);
+            break;
+        case Reduce::MinMax:
+            for (size_t c = 0; c < columns; ++c) {
+                bool first = rows_seen % factor == 0;
+                low[c] = first ? row[c] : std::min(low[c], row[c]);
+                high[c] = first ? row[c] : std::max(high[c], row[c]);
+            }
+            if ((rows_seen + 1) % factor == 0) {
+                emit(low.data());
+                emit(high.data());
+            }
+            break;
+        }
+        rows_seen++;
+    }
+
+    void close() {
+        if (!file) return;
+        if (reduce == Reduce::MinMax) flushGroup();
+        if (format == Format::Binary) flushBinary();
+        else flushText();
+        std::fclose(file);
+        file = nullptr;
+    }
+};
+
 // Функция для построения временных характеристик при заданном запаздывании
 void plotTimeResponse(double a0, double a1, double a2, double k,
     double tau, double dt, double simulation_time,
-    const std::string& filename) {
+    const std::string& filename,
+    TraceSink::Format format = TraceSink::Format::Text,
+    TraceSink::Reduce reduce = TraceSink::Reduce::None, int factor = 1) {
 
-    std::ofstream output(filename);
-    output << "time,state,goal\n";
+    TraceSink output(filename, { "time", "state", "goal" }, format, reduce, factor);
 
     DynamicSystem system(a0, a1, a2, k, tau, dt);
     int steps = static_cast<int>(simulation_time / dt);
@@ -145,16 +1176,50 @@ void plotTimeResponse(double a0, double a1, double a2, double k,
         double t = i * dt;
         system.step(t);
 
-        double state = system.getCurrentState();
-        double goal = heaviside(t);
-
-        output << t << " " << state << " " << goal << "\n";
+        double row[3] = { t, system.getCurrentState(), heaviside(t) };
+        output.write(row);
     }
+}
 
-    output.close();
+// Скорость записи трасс: старый ofstream << и TraceSink в разных режимах
+void traceBenchmark(double a0, double a1, double a2, double k, double tau) {
+    double dt = 1e-4;
+    double simulation_time = 200.0;
+    int steps = static_cast<int>(simulation_time / dt);
+
+    auto timed = [&](const char* label, const std::function<void()>& body) {
+        auto start = std::chrono::high_resolution_clock::now();
+        body();
+        auto end = std::chrono::high_resolution_clock::now();
+        double sec = std::chrono::duration<double>(end - start).count();
+        std::cout << label << ": " << sec << " s (" << steps / sec / 1e6 << " M rows/s)" << std::endl;
+    };
+
+    timed("ofstream", [&]() {
+        std::ofstream output("trace_bench.txt");
+        output << "time,state,goal\n";
+        DynamicSystem system(a0, a1, a2, k, tau, dt);
+        for (int i = 0; i < steps; ++i) {
+            double t = i * dt;
+            system.step(t);
+            output << t << " " << system.getCurrentState() << " " << heaviside(t) << "\n";
+        }
+    });
+    timed("TraceSink text", [&]() {
+        plotTimeResponse(a0, a1, a2, k, tau, dt, simulation_time, "trace_bench.txt");
+    });
+    timed("TraceSink binary", [&]() {
+        plotTimeResponse(a0, a1, a2, k, tau, dt, simulation_time, "trace_bench.bin", TraceSink::Format::Binary);
+    });
+    timed("TraceSink text, min/max x100", [&]() {
+        plotTimeResponse(a0, a1, a2, k, tau, dt, simulation_time, "trace_bench.txt",
+            TraceSink::Format::Text, TraceSink::Reduce::MinMax, 100);
+    });
+    std::remove("trace_bench.txt");
+    std::remove("trace_bench.bin");
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     // Параметры системы
     double a0 = 1.0;    // Коэффициент при x
     double a1 = 2.0;    // Коэффициент при x'
@@ -164,6 +1229,40 @@ int main() {
     double dt = 0.01;   // Шаг по времени
     double simulation_time = 20.0; // Время моделирования
 
+    // Сравнение интеграторов по точности и стоимости
+    if (argc > 1 && std::string(argv[1]) == "integrators") {
+        integratorAccuracy(a0, a1, a2, k, 0.07, simulation_time);
+        integratorAccuracy(a0, a1, a2, k, 0.37, simulation_time);
+        integratorAccuracy(a0, a1, a2, k, 0.5, simulation_time);
+        return 0;
+    }
+
+    // Граница устойчивости по квазиполиному и сверка с моделированием
+    if (argc > 1 && std::string(argv[1]) == "boundary") {
+        DelayStability stability = delayStability(a0, a1, a2, k, 2.0);
+        std::cout << "Critical delay for k = " << k << ": " << stability.tau_critical << std::endl;
+        stabilityBoundary(a0, a1, a2, 0.1, 5.0, 0.05, 0.0, 2.0, 0.01, dt, simulation_time, "stability_boundary.txt");
+        return 0;
+    }
+
+    // Обобщенные объекты порядка N с разными регуляторами
+    if (argc > 1 && std::string(argv[1]) == "plants") {
+        plantLibraryDemo(a0, a1, a2, k, 0.5, dt);
+        return 0;
+    }
+
+    // Скорость записи трасс
+    if (argc > 1 && std::string(argv[1]) == "trace") {
+        traceBenchmark(a0, a1, a2, k, 0.5);
+        return 0;
+    }
+
+    // Карта устойчивости по (k, tau)
+    if (argc > 1 && std::string(argv[1]) == "grid") {
+        stabilityGrid(a0, a1, a2, 0.1, 5.0, 0.05, 0.0, 2.0, 0.01, dt, simulation_time, "stability_grid.txt");
+        return 0;
+    }
+
     // Анализ устойчивости в зависимости от запаздывания
     std::cout << "Stable system analisys:" << std::endl;
     stabilityAnalysis(a0, a1, a2, k, 0.0, 2.0, 0.1, dt, simulation_time);
@@ -7,9 +7,47 @@
 #include <random>
 #include <unordered_map>
 #include <limits>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 using namespace std;
 
+// Процессорное время текущего потока, с. В MSVC clock() возвращает настенное время,
+// а GetThreadTimes меняется раз в квант планировщика, поэтому там считаем такты потока
+// и переводим в секунды по частоте, замеренной один раз
+double cpuSeconds() {
+#ifdef _WIN32
+    static const double seconds_per_cycle = [] {
+        ULONG64 begin, end;
+        QueryThreadCycleTime(GetCurrentThread(), &begin);
+        auto start = chrono::steady_clock::now();
+        while (chrono::steady_clock::now() - start < chrono::milliseconds(50)) {}
+        QueryThreadCycleTime(GetCurrentThread(), &end);
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count() / (end - begin);
+    }();
+    ULONG64 cycles;
+    QueryThreadCycleTime(GetCurrentThread(), &cycles);
+    return cycles * seconds_per_cycle;
+#else
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
 class Module {
 public:
     int id;
@@ -86,24 +124,331 @@ public:
     }
 };
 
+// Индексированная двоичная куча агентов по нагрузке.
+// Вершина (наименее или наиболее загруженный агент) - за O(1),
+// изменение нагрузки агента и удаление - за O(log A).
+// При равной нагрузке в min-куче выше агент с меньшим номером, в max-куче - с большим
+template <bool MaxHeap>
+class LoadHeap {
+private:
+    vector<int> heap; // Номера агентов
+    vector<int> pos; // Позиция агента в куче (-1 если его нет в куче)
+    vector<double> key; // Нагрузка агента
+
+    bool above(int a, int b) const {
+        if (key[a] != key[b]) return MaxHeap ? key[a] > key[b] : key[a] < key[b];
+        return MaxHeap ? a > b : a < b;
+    }
+
+    void place(int i, int agent_id) {
+        heap[i] = agent_id;
+        pos[agent_id] = i;
+    }
+
+    void siftUp(int i) {
+        int agent_id = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!above(agent_id, heap[parent])) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, agent_id);
+    }
+
+    void siftDown(int i) {
+        int agent_id = heap[i];
+        int n = heap.size();
+        while (2 * i + 1 < n) {
+            int child = 2 * i + 1;
+            if (child + 1 < n && above(heap[child + 1], heap[child])) child++;
+            if (!above(heap[child], agent_id)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, agent_id);
+    }
+
+public:
+    // Все агенты с заданными нагрузками
+    void build(const vector<Agent>& agents) {
+        int n = agents.size();
+        heap.resize(n);
+        pos.resize(n);
+        key.resize(n);
+        for (int i = 0; i < n; i++) {
+            key[i] = agents[i].current_load;
+            place(i, i);
+        }
+        for (int i = n / 2 - 1; i >= 0; i--) siftDown(i);
+    }
+
+    int top() const { return heap[0]; }
+    int size() const { return heap.size(); }
+
+    // Новая нагрузка агента; если агента нет в куче, она запоминается до push
+    void update(int agent_id, double load) {
+        bool increased = load > key[agent_id];
+        key[agent_id] = load;
+        if (pos[agent_id] == -1) return;
+        if (increased == MaxHeap) siftUp(pos[agent_id]);
+        else siftDown(pos[agent_id]);
+    }
+
+    void remove(int agent_id) {
+        int i = pos[agent_id];
+        int last = heap.back();
+        heap.pop_back();
+        pos[agent_id] = -1;
+        if (last == agent_id) return;
+        place(i, last);
+        siftUp(i);
+        siftDown(pos[last]);
+    }
+
+    void push(int agent_id) {
+        heap.push_back(agent_id);
+        siftUp(heap.size() - 1);
+    }
+};
+
+// Приемники событий балансировщика. Приемник - параметр шаблона
+// BasicLoadBalancer, поэтому вызовы пустого приемника компилятор убирает целиком
+
+// Без записи событий
+// Первый аргумент событий - модельное время события
+struct NullSink {
+    void assigned(double, int, int, double) {}
+    void distributed(const vector<Agent>&) {}
+    void scheduled(double, const vector<Agent>&) {}
+    void executionStarted() {}
+    void started(double, int, int, double) {}
+    void completed(double, int) {}
+    void ready(double, int) {}
+    void failed(double, int, int) {}
+    void moved(double, int, int, int, bool) {}
+    void rebalancing(double) {}
+    void rebalanced(double, const vector<Agent>&) {}
+    void finished(double, int, int) {}
+    void decisionStarted() {}
+    void decisionFinished() {}
+};
+
+// Двоичная запись событий в кольцевой буфер фиксированного размера:
+// хранятся последние capacity событий, без форматирования и выделения памяти.
+// Все виды событий используют одну раскладку (время, модуль, агент)
+class RingRecorder : public NullSink {
+public:
+    enum Kind : unsigned char { ASSIGNED, STARTED, COMPLETED, READY, FAILED, MOVED, REBALANCED, FINISHED };
+
+    struct Record {
+        Kind kind;
+        double time; // Модельное время события
+        int module; // Модуль (-1, если событие не относится к модулю)
+        int agent; // Агент (для MOVED - исходный агент)
+        int target; // Для MOVED - новый агент
+        double value; // Нагрузка модуля (для REBALANCED - число перемещений, для FINISHED - выполненных модулей)
+    };
+
+private:
+    vector<Record> buffer;
+    size_t mask;
+    size_t count = 0;
+    int moves = 0; // Перемещения с прошлой балансировки
+
+    void put(Kind kind, double time, int module, int agent, int target = -1, double value = 0) {
+        buffer[count++ & mask] = { kind, time, module, agent, target, value };
+    }
+
+public:
+    explicit RingRecorder(int capacity_log2 = 16)
+        : buffer(size_t(1) << capacity_log2), mask((size_t(1) << capacity_log2) - 1) {}
+
+    void assigned(double time, int module_id, int agent_id, double load) { put(ASSIGNED, time, module_id, agent_id, -1, load); }
+    void started(double time, int agent_id, int module_id, double load) { put(STARTED, time, module_id, agent_id, -1, load); }
+    void completed(double time, int module_id) { put(COMPLETED, time, module_id, -1); }
+    void ready(double time, int module_id) { put(READY, time, module_id, -1); }
+    void failed(double time, int agent_id, int module_id) { put(FAILED, time, module_id, agent_id); }
+    void moved(double time, int module_id, int from, int to, bool) {
+        put(MOVED, time, module_id, from, to);
+        moves++;
+    }
+    // Запись после балансировки, когда перемещения уже сделаны
+    void rebalanced(double time, const vector<Agent>&) {
+        put(REBALANCED, time, -1, -1, -1, moves);
+        moves = 0;
+    }
+    void finished(double time, int completed_modules, int) { put(FINISHED, time, -1, -1, -1, completed_modules); }
+
+    // Всего записано событий (в буфере - последние min(total, capacity))
+    size_t total() const { return count; }
+
+    // i-е из сохраненных событий, от старых к новым
+    const Record& operator[](size_t i) const {
+        size_t stored = min(count, buffer.size());
+        return buffer[(count - stored + i) & mask];
+    }
+    size_t size() const { return min(count, buffer.size()); }
+};
+
+// Процессорное время решений балансировки во время выполнения (для замеров).
+// Из каждого замера вычитается цена самого вызова часов, иначе при дешевых
+// решениях (диффузия) в сумме остаются в основном накладные расходы таймера
+class DecisionTimer : public NullSink {
+private:
+    double start = 0;
+    double total = 0;
+
+public:
+    // Средняя цена одного вызова cpuSeconds(), с
+    static double timerCost() {
+        static const double cost = [] {
+            const int calls = 10000;
+            double begin = cpuSeconds();
+            for (int i = 0; i < calls; i++) cpuSeconds();
+            return (cpuSeconds() - begin) / (calls + 1);
+        }();
+        return cost;
+    }
+
+    void decisionStarted() { start = cpuSeconds(); }
+    void decisionFinished() { total += cpuSeconds() - start - timerCost(); }
+
+    double seconds() const { return max(0.0, total); }
+};
+
+// Печать событий в консоль
+struct ConsolePrinter {
+    void assigned(double, int module_id, int agent_id, double load) {
+        cout << "Модуль " << module_id << " назначен агенту " << agent_id<< " (нагрузка: " << load << ")" << endl;
+    }
+    void distributed(const vector<Agent>& agents) {
+        cout << "Начальное распределение завершено" << endl;
+        printDistribution(agents);
+    }
+    void scheduled(double makespan, const vector<Agent>& agents) {
+        cout << "Списочное распределение завершено, плановое время: " << makespan << endl;
+        printDistribution(agents);
+    }
+    void executionStarted() {
+        cout << "\nНачало выполнения приложения" << endl;
+    }
+    void started(double, int agent_id, int module_id, double load) {
+        cout << "Агент " << agent_id << " выполняет модуль " << module_id << " (нагрузка: " << load << ")" << endl;
+    }
+    void completed(double time, int module_id) {
+        cout << "Модуль " << module_id << " завершен (время " << time << ")" << endl;
+    }
+    void ready(double, int module_id) {
+        cout << "Модуль " << module_id << " готов к выполнению и добавлен в очередь" << endl;
+    }
+    void failed(double, int agent_id, int module_id) {
+        cout << "Отказ на агенте " << agent_id << " при выполнении модуля " << module_id << endl;
+    }
+    void moved(double, int module_id, int from, int to, bool rebalance) {
+        if (rebalance) cout << "Балансировка: перемещение модуля " << module_id << " с агента " << from << " на агента " << to << endl;
+        else cout << "Перемещение модуля " << module_id << " с агента "<< from << " на агента " << to << endl;
+    }
+    void rebalancing(double) {
+        cout << "Выполняется динамическая балансировка" << endl;
+    }
+    void rebalanced(double, const vector<Agent>& agents) {
+        printDistribution(agents);
+    }
+    void decisionStarted() {}
+    void decisionFinished() {}
+    void finished(double time, int completed_modules, int total_modules) {
+        if (completed_modules < total_modules) {
+            cout << "Граф содержит цикл: выполнено " << completed_modules << " из " << total_modules << endl;
+        }
+        cout << "Общее время выполнения: " << time << endl;
+    }
+
+    // Вывод текущего распределения
+    void printDistribution(const vector<Agent>& agents) {
+        cout << "\nТекущее распределение нагрузки:" << endl;
+        for (const auto& agent : agents) {
+            cout << "Агент " << agent.id << ": нагрузка=" << agent.current_load<< ", модули=[";
+            for (size_t i = 0; i < agent.assigned_modules.size(); i++) {
+                cout << agent.assigned_modules[i];
+                if (i < agent.assigned_modules.size() - 1) cout << ", ";
+            }
+            cout << "]" << endl;
+        }
+        cout << endl;
+    }
+};
+
+// Способ динамической балансировки
+enum Rebalancer {
+    PAIRING, // Пары из самых и наименее загруженных агентов всего графа
+    DIFFUSION // Обмен нагрузкой только с соседями по графу агентов
+};
+
 // Основной класс для балансировки нагрузки
-class LoadBalancer {
+template <class EventSink>
+class BasicLoadBalancer {
 private:
     ApplicationGraph app_graph;
     AgentGraph agent_graph;
     mt19937 rng;
 
-    // Текущее распределение: модуль -> агент
-    unordered_map<int, int> module_to_agent;
+    // Состояние модулей - плотные массивы по номеру модуля (номера 0..V-1)
+    // Текущее распределение: модуль -> агент (-1 если не назначен)
+    vector<int> module_to_agent;
+    // Позиция модуля в списке assigned_modules его агента
+    vector<int> module_slot;
+    // Назначенные, но еще не начатые модули каждого агента и позиция модуля в этом списке
+    vector<vector<int>> pending_modules;
+    vector<int> pending_slot;
     // Время завершения модулей
-    unordered_map<int, double> module_completion_time;
+    vector<double> module_completion_time;
     // 0-не начат, 1-выполняется, 2-завершен
-    unordered_map<int, int> module_status;
+    vector<char> module_status;
     // Очередь готовых к выполнению модулей
     queue<int> ready_modules;
 
+    // Агенты по нагрузке: наименее и наиболее загруженный
+    LoadHeap<false> least_loaded;
+    LoadHeap<true> most_loaded;
+
+    // Событийное выполнение
+    vector<int> remaining_deps; // Сколько предшественников еще не завершено
+    vector<double> data_ready; // Когда данные всех предшественников дойдут до агента модуля
+    vector<char> awaiting_data; // Событие прихода данных к модулю еще в куче
+    // Готовые модули каждого агента: (приоритет, -порядок поступления, модуль)
+    vector<priority_queue<tuple<double, int, int>>> agent_queues;
+    int dispatch_counter = 0;
+    // События завершения: (время, модуль), ближайшее сверху
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<pair<double, int>>> events;
+    vector<int> moved_modules; // Модули, перемещенные последней балансировкой
+    double event_time = 0; // Модельное время обрабатываемого события (для приемника)
+
+    double failure_rate = 0.05; // Вероятность отказа при запуске модуля
+    bool rebalancing = true; // Динамическая балансировка после завершений
+    Rebalancer rebalancer = PAIRING;
+    long long migrations = 0; // Модули, перемещенные балансировкой
+    static const int DIFFUSION_CANDIDATES = 8; // Сколько модулей агента рассматривать для переноса
+    EventSink sink; // Приемник событий
+
+    // Списочное планирование
+    vector<double> module_priority; // Приоритет в очереди агента (больше - раньше)
+    double comm_per_hop = 0; // Время передачи данных по одной связи графа агентов
+    vector<vector<int>> hops; // Расстояния между агентами в связях
+
 public:
-    LoadBalancer() : rng(random_device{}()) {}
+    BasicLoadBalancer() : rng(random_device{}()) {}
+
+    void setFailureRate(double rate) { failure_rate = rate; }
+    void setRebalancing(bool enabled) { rebalancing = enabled; }
+    void setRebalancer(Rebalancer method) { rebalancer = method; }
+    long long migrationCount() const { return migrations; }
+    EventSink& eventSink() { return sink; }
+    void setSeed(unsigned seed) { rng.seed(seed); }
+    void setCommCost(double per_hop) { comm_per_hop = per_hop; }
+
+    // Текущее распределение модулей по агентам
+    const vector<int>& placement() const { return module_to_agent; }
 
     // Инициализация графов
     void initializeGraphs(const ApplicationGraph& app, const AgentGraph& agents) {
@@ -112,15 +457,45 @@ public:
         app_graph.findStartEndModules();
 
         // Инициализация статусов
-        for (const auto& module : app_graph.modules) {
-            module_status[module.id] = 0;
+        module_status.assign(app_graph.modules.size(), 0);
+        module_priority.assign(app_graph.modules.size(), 0);
+        hops.clear();
+        rebuildLoadHeaps();
+    }
+
+    void rebuildLoadHeaps() {
+        least_loaded.build(agent_graph.agents);
+        most_loaded.build(agent_graph.agents);
+    }
+
+    // Изменение нагрузки агента с обновлением куч
+    void changeLoad(int agent_id, double delta) {
+        Agent& agent = agent_graph.agents[agent_id];
+        agent.current_load += delta;
+        least_loaded.update(agent_id, agent.current_load);
+        most_loaded.update(agent_id, agent.current_load);
+    }
+
+    // Снять все назначения перед новым распределением
+    void clearAssignments() {
+        module_to_agent.assign(app_graph.modules.size(), -1);
+        module_slot.assign(app_graph.modules.size(), -1);
+        pending_modules.assign(agent_graph.agents.size(), vector<int>());
+        pending_slot.assign(app_graph.modules.size(), -1);
+        module_completion_time.assign(app_graph.modules.size(), 0);
+        ready_modules = queue<int>();
+        event_time = 0;
+        for (auto& agent : agent_graph.agents) {
+            agent.current_load = 0;
+            agent.assigned_modules.clear();
         }
+        rebuildLoadHeaps();
     }
 
     // Начальное распределение нагрузки
     void initialDistribution() {
-        module_to_agent.clear();
-        module_completion_time.clear();
+        clearAssignments();
+        module_priority.assign(app_graph.modules.size(), 0);
 
         // Распределяем все модули
         vector<int> all_modules;
@@ -144,133 +519,407 @@ public:
             ready_modules.push(start_id);
         }
 
-        cout << "Начальное распределение завершено" << endl;
-        printDistribution();
+        sink.distributed(agent_graph.agents);
     }
 
     // Поиск наименее загруженного агента
     int findLeastLoadedAgent() {
-        int best_agent = 0;
-        double min_load = agent_graph.agents[0].current_load;
-
-        for (int i = 1; i < agent_graph.agents.size(); i++) {
-            if (agent_graph.agents[i].current_load < min_load) {
-                min_load = agent_graph.agents[i].current_load;
-                best_agent = i;
-            }
-        }
-        return best_agent;
+        return least_loaded.top();
     }
 
     // Назначение модуля агенту
     void assignModuleToAgent(int module_id, int agent_id) {
         module_to_agent[module_id] = agent_id;
         const Module& module = app_graph.getModule(module_id);
+        module_slot[module_id] = agent_graph.agents[agent_id].assigned_modules.size();
         agent_graph.agents[agent_id].assigned_modules.push_back(module_id);
-        agent_graph.agents[agent_id].current_load += module.load;
+        if (module_status[module_id] == 0) {
+            pending_slot[module_id] = pending_modules[agent_id].size();
+            pending_modules[agent_id].push_back(module_id);
+        }
+        changeLoad(agent_id, module.load);
+
+        sink.assigned(event_time, module_id, agent_id, module.load);
+    }
+
+    // Снятие модуля с его агента за O(1): на его место ставится последний модуль списка
+    void unassignModule(int module_id) {
+        Agent& agent = agent_graph.agents[module_to_agent[module_id]];
+        int slot = module_slot[module_id];
+        int last = agent.assigned_modules.back();
+        agent.assigned_modules[slot] = last;
+        module_slot[last] = slot;
+        agent.assigned_modules.pop_back();
+        removePending(module_id);
+        changeLoad(module_to_agent[module_id], -app_graph.getModule(module_id).load);
+        module_to_agent[module_id] = -1;
+        module_slot[module_id] = -1;
+    }
 
-        cout << "Модуль " << module_id << " назначен агенту " << agent_id<< " (нагрузка: " << module.load << ")" << endl;
+    // Модуль больше не ожидает запуска на своем агенте
+    void removePending(int module_id) {
+        int slot = pending_slot[module_id];
+        if (slot == -1) return;
+        vector<int>& pending = pending_modules[module_to_agent[module_id]];
+        int last = pending.back();
+        pending[slot] = last;
+        pending_slot[last] = slot;
+        pending.pop_back();
+        pending_slot[module_id] = -1;
     }
 
-    // Выполнение приложения
+    // Выполнение приложения: дискретно-событийная модель.
+    // Каждый агент выполняет свои модули по одному, разные агенты - параллельно.
+    // Модуль готов, когда счетчик незавершенных предшественников обнулился,
+    // и запускается, как только освободится его агент. Время продвигается
+    // от одного завершения к следующему по куче событий: O((V+E) log V)
     double executeApplication() {
         double current_time = 0;
         int completed_modules = 0;
         int total_modules = app_graph.modules.size();
 
-        cout << "\nНачало выполнения приложения" << endl;
+        event_time = 0;
+        sink.executionStarted();
+
+        remaining_deps.assign(total_modules, 0);
+        for (const auto& module : app_graph.modules) {
+            remaining_deps[module.id] = module.prev_modules.size();
+        }
+        data_ready.assign(total_modules, 0);
+        awaiting_data.assign(total_modules, 0);
+        agent_queues.assign(agent_graph.agents.size(), {});
+        dispatch_counter = 0;
+        events = decltype(events)();
+        for (auto& agent : agent_graph.agents) {
+            agent.current_module = -1;
+            agent.completion_time = 0;
+        }
 
-        while (completed_modules < total_modules) {
-            // Если есть готовые модули, выполняем их
-            if (!ready_modules.empty()) {
-                int module_id = ready_modules.front();
-                ready_modules.pop();
+        while (!ready_modules.empty()) {
+            int module_id = ready_modules.front();
+            ready_modules.pop();
+            dispatchModule(module_id, current_time);
+        }
 
-                if (module_status[module_id] != 0) continue;
+        while (completed_modules < total_modules && !events.empty()) {
+            int module_id = events.top().second;
+            current_time = events.top().first;
+            event_time = current_time;
+            events.pop();
+
+            // Отрицательный номер - событие прихода данных к готовому модулю
+            if (module_id < 0) {
+                awaiting_data[~module_id] = 0;
+                dispatchModule(~module_id, current_time);
+                continue;
+            }
 
-                int agent_id = module_to_agent[module_id];
-                const Module& module = app_graph.getModule(module_id);
+            const Module& module = app_graph.getModule(module_id);
+            int agent_id = module_to_agent[module_id];
+
+            // Завершение модуля
+            module_status[module_id] = 2;
+            completed_modules++;
+
+            sink.completed(current_time, module_id);
+
+            // Освобождение агента
+            changeLoad(agent_id, -module.load);
+            agent_graph.agents[agent_id].current_module = -1;
+
+            // Следующие модули готовы, когда завершены все их предшественники
+            // (и данные от них дошли до агента модуля)
+            for (int next_id : module.next_modules) {
+                double arrival = current_time + commCost(agent_id, module_to_agent[next_id]);
+                data_ready[next_id] = max(data_ready[next_id], arrival);
+                if (--remaining_deps[next_id] == 0) {
+                    sink.ready(current_time, next_id);
+                    if (data_ready[next_id] > current_time) {
+                        events.push({ data_ready[next_id], ~next_id });
+                        awaiting_data[next_id] = 1;
+                    }
+                    else {
+                        dispatchModule(next_id, current_time);
+                    }
+                }
+            }
+            startNextModule(agent_id, current_time);
 
-                // Проверка на отказ оборудования
-                if (uniform_real_distribution<double>(0, 1)(rng) < 0.05) {
-                    cout << "Отказ на агенте " << agent_id<< " при выполнении модуля " << module_id << endl;
-                    dynamicRebalance(module_id, agent_id);
-                    agent_id = module_to_agent[module_id]; // Обновляем agent_id после перераспределения
+            // Проверка необходимости динамической балансировки
+            if (rebalancing) {
+                sink.decisionStarted();
+                if (rebalancer == DIFFUSION) {
+                    diffusionRebalance(agent_id);
                 }
+                else if (needRebalancing()) {
+                    sink.rebalancing(current_time);
+                    dynamicRebalance(-1, -1); // Общая балансировка
+                }
+                sink.decisionFinished();
+                redispatchMoved(current_time);
+            }
+        }
+        sink.finished(current_time, completed_modules, total_modules);
+
+        return current_time;
+    }
 
-                // Выполнение модуля
-                cout << "Агент " << agent_id << " выполняет модуль " << module_id<< " (нагрузка: " << module.load << ")" << endl;
+    // Готовый модуль встает в очередь своего агента
+    void dispatchModule(int module_id, double now) {
+        int agent_id = module_to_agent[module_id];
+        agent_queues[agent_id].emplace(module_priority[module_id], -dispatch_counter++, module_id);
+        startNextModule(agent_id, now);
+    }
 
-                module_status[module_id] = 1;
-                double completion_time = current_time + module.load;
-                module_completion_time[module_id] = completion_time;
+    // Если агент свободен - запускаем готовый модуль с наибольшим приоритетом
+    // (при равных приоритетах - в порядке поступления)
+    void startNextModule(int agent_id, double now) {
+        Agent& agent = agent_graph.agents[agent_id];
+        auto& agent_queue = agent_queues[agent_id];
+        while (agent.current_module == -1 && !agent_queue.empty()) {
+            int module_id = get<2>(agent_queue.top());
+            agent_queue.pop();
+            // Модуль могли перенести на другого агента балансировкой
+            if (module_status[module_id] != 0 || module_to_agent[module_id] != agent_id) continue;
+
+            // Проверка на отказ оборудования
+            if (failure_rate > 0 && uniform_real_distribution<double>(0, 1)(rng) < failure_rate) {
+                sink.failed(now, agent_id, module_id);
+                sink.decisionStarted();
+                dynamicRebalance(module_id, agent_id);
+                sink.decisionFinished();
+                if (module_to_agent[module_id] != agent_id) {
+                    dispatchModule(module_id, now);
+                    continue;
+                }
+            }
 
-                // Завершение модуля
-                module_status[module_id] = 2;
-                completed_modules++;
-                current_time = completion_time;
+            const Module& module = app_graph.getModule(module_id);
+            sink.started(now, agent_id, module_id, module.load);
 
-                cout << "Модуль " << module_id << " завершен" << endl;
+            removePending(module_id);
+            module_status[module_id] = 1;
+            agent.current_module = module_id;
+            agent.completion_time = now + module.load; // Агент занят до этого момента
+            module_completion_time[module_id] = agent.completion_time;
+            events.push({ agent.completion_time, module_id });
+        }
+    }
+
+    // Готовые модули, перенесенные балансировкой, ставим в очередь нового агента.
+    // Модуль, данные к которому еще идут, поставит в очередь событие их прихода
+    void redispatchMoved(double now) {
+        vector<int> moved;
+        moved.swap(moved_modules);
+        for (int module_id : moved) {
+            if (module_status[module_id] == 0 && remaining_deps[module_id] == 0 && !awaiting_data[module_id]) {
+                dispatchModule(module_id, now);
+            }
+        }
+    }
 
-                // Освобождение агента
-                agent_graph.agents[agent_id].current_load -= module.load;
-                agent_graph.agents[agent_id].current_module = -1;
+    // Время передачи результата модуля между агентами
+    double commCost(int from_agent, int to_agent) {
+        if (comm_per_hop == 0 || from_agent == to_agent) return 0;
+        if (hops.empty()) computeHops();
+        return comm_per_hop * hops[from_agent][to_agent];
+    }
 
-                // Добавление следующих модулей в очередь, если они готовы
-                for (int next_id : module.next_modules) {
-                    if (isModuleReady(next_id)) {
-                        ready_modules.push(next_id);
-                        cout << "Модуль " << next_id << " готов к выполнению и добавлен в очередь" << endl;
+    // Кратчайшие расстояния между агентами поиском в ширину из каждого агента.
+    // Между несвязанными агентами считаем расстояние равным числу агентов
+    void computeHops() {
+        int n = agent_graph.agents.size();
+        hops.assign(n, vector<int>(n, n));
+        vector<int> bfs(n);
+        for (int source = 0; source < n; source++) {
+            vector<int>& dist = hops[source];
+            dist[source] = 0;
+            int head = 0, tail = 0;
+            bfs[tail++] = source;
+            while (head < tail) {
+                int agent_id = bfs[head++];
+                for (int neighbor : agent_graph.agents[agent_id].neighbors) {
+                    if (dist[neighbor] == n) {
+                        dist[neighbor] = dist[agent_id] + 1;
+                        bfs[tail++] = neighbor;
                     }
                 }
+            }
+        }
+    }
 
-                // Проверка необходимости динамической балансировки
-                if (needRebalancing()) {
-                    cout << "Выполняется динамическая балансировка" << endl;
-                    dynamicRebalance(-1, -1); // Общая балансировка
-                }
+    // Среднее время передачи между разными агентами (для рангов, пока агенты не выбраны)
+    double averageCommCost() {
+        int n = agent_graph.agents.size();
+        if (comm_per_hop == 0 || n < 2) return 0;
+        if (hops.empty()) computeHops();
+        double total = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) total += hops[i][j];
+        }
+        return comm_per_hop * total / ((double)n * (n - 1));
+    }
+
+    // Топологический порядок модулей (алгоритм Кана)
+    vector<int> topologicalOrder() {
+        int n = app_graph.modules.size();
+        vector<int> in_degree(n), order;
+        order.reserve(n);
+        for (const auto& module : app_graph.modules) {
+            in_degree[module.id] = module.prev_modules.size();
+            if (in_degree[module.id] == 0) order.push_back(module.id);
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+            for (int next_id : app_graph.getModule(order[i]).next_modules) {
+                if (--in_degree[next_id] == 0) order.push_back(next_id);
+            }
+        }
+        return order;
+    }
+
+    // Восходящий ранг: длина самого длинного пути от модуля до конца графа
+    vector<double> upwardRanks(const vector<int>& order, double comm) {
+        vector<double> rank(app_graph.modules.size(), 0);
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            const Module& module = app_graph.getModule(*it);
+            double longest = 0;
+            for (int next_id : module.next_modules) longest = max(longest, comm + rank[next_id]);
+            rank[module.id] = module.load + longest;
+        }
+        return rank;
+    }
+
+    // Нисходящий ранг: длина самого длинного пути от начала графа до модуля
+    vector<double> downwardRanks(const vector<int>& order, double comm) {
+        vector<double> rank(app_graph.modules.size(), 0);
+        for (int module_id : order) {
+            const Module& module = app_graph.getModule(module_id);
+            for (int next_id : module.next_modules) {
+                rank[next_id] = max(rank[next_id], rank[module_id] + module.load + comm);
             }
-            else {
-                // Если нет готовых модулей, увеличиваем время
-                current_time += 0.1;
+        }
+        return rank;
+    }
 
-                bool found_ready = false;
-                for (const auto& module : app_graph.modules) {
-                    if (module_status[module.id] == 0 && isModuleReady(module.id)) {
-                        ready_modules.push(module.id);
-                        found_ready = true;
-                        cout << "Модуль " << module.id << " обнаружен как готовый и добавлен в очередь" << endl;
-                    }
-                }
+    // Распределение HEFT: модули в порядке убывания восходящего ранга,
+    // каждый - агенту с наименьшим временем завершения с учетом передачи данных.
+    // Возвращает плановое время выполнения
+    double heftDistribution() {
+        vector<int> order = topologicalOrder();
+        vector<double> rank = upwardRanks(order, averageCommCost());
+        return listSchedule(rank, vector<char>(), -1);
+    }
 
+    // Распределение CPOP: приоритет - сумма восходящего и нисходящего рангов.
+    // Модули критического пути назначаются одному агенту (с наименьшей суммой
+    // расстояний до остальных), прочие - агенту с наименьшим временем завершения
+    double cpopDistribution() {
+        vector<int> order = topologicalOrder();
+        double comm = averageCommCost();
+        vector<double> up = upwardRanks(order, comm), down = downwardRanks(order, comm);
+
+        vector<double> priority(up.size());
+        double critical = 0;
+        for (size_t i = 0; i < up.size(); i++) {
+            priority[i] = up[i] + down[i];
+            critical = max(critical, priority[i]);
+        }
+
+        // Критический путь: от начального модуля с наибольшим приоритетом
+        // по следующим модулям с тем же приоритетом
+        vector<char> on_critical_path(up.size(), 0);
+        const double eps = 1e-9 * max(1.0, critical);
+        int module_id = -1;
+        for (int start_id : app_graph.start_modules) {
+            if (priority[start_id] >= critical - eps) module_id = start_id;
+        }
+        while (module_id != -1) {
+            on_critical_path[module_id] = 1;
+            int next_on_path = -1;
+            for (int next_id : app_graph.getModule(module_id).next_modules) {
+                if (priority[next_id] >= critical - eps) next_on_path = next_id;
             }
+            module_id = next_on_path;
         }
-        cout << "Общее время выполнения: " << current_time << endl;
 
-        return current_time;
+        int critical_agent = 0;
+        if (comm_per_hop > 0) {
+            if (hops.empty()) computeHops();
+            int n = agent_graph.agents.size();
+            long long best = numeric_limits<long long>::max();
+            for (int i = 0; i < n; i++) {
+                long long total = 0;
+                for (int d : hops[i]) total += d;
+                if (total < best) {
+                    best = total;
+                    critical_agent = i;
+                }
+            }
+        }
+        return listSchedule(priority, on_critical_path, critical_agent);
     }
 
-    // Проверка готовности модуля к выполнению
-    bool isModuleReady(int module_id) {
-        const Module& module = app_graph.getModule(module_id);
-        for (int prev_id : module.prev_modules) {
-            if (module_status[prev_id] != 2) {
-                return false;
+    // Общее списочное планирование: из готовых модулей берется модуль с наибольшим
+    // приоритетом и назначается агенту с наименьшим временем завершения (без вставки
+    // в промежутки простоя - агент выполняет свои готовые модули по приоритету).
+    // Модули с отметкой pinned назначаются агенту pinned_agent
+    double listSchedule(const vector<double>& priority, const vector<char>& pinned, int pinned_agent) {
+        clearAssignments();
+        int n = app_graph.modules.size();
+        int agent_count = agent_graph.agents.size();
+        module_priority = priority;
+
+        vector<double> finish(n, 0), agent_ready(agent_count, 0);
+        vector<int> in_degree(n);
+        priority_queue<pair<double, int>> ready;
+        for (const auto& module : app_graph.modules) {
+            in_degree[module.id] = module.prev_modules.size();
+            if (in_degree[module.id] == 0) ready.push({ priority[module.id], module.id });
+        }
+
+        double makespan = 0;
+        while (!ready.empty()) {
+            int module_id = ready.top().second;
+            ready.pop();
+            const Module& module = app_graph.getModule(module_id);
+
+            int best_agent = 0;
+            double best_finish = numeric_limits<double>::max();
+            for (int agent_id = 0; agent_id < agent_count; agent_id++) {
+                if (!pinned.empty() && pinned[module_id] && agent_id != pinned_agent) continue;
+                double start = agent_ready[agent_id];
+                for (int prev_id : module.prev_modules) {
+                    start = max(start, finish[prev_id] + commCost(module_to_agent[prev_id], agent_id));
+                }
+                if (start + module.load < best_finish) {
+                    best_finish = start + module.load;
+                    best_agent = agent_id;
+                }
+            }
+
+            assignModuleToAgent(module_id, best_agent);
+            finish[module_id] = best_finish;
+            agent_ready[best_agent] = best_finish;
+            makespan = max(makespan, best_finish);
+
+            for (int next_id : module.next_modules) {
+                if (--in_degree[next_id] == 0) ready.push({ priority[next_id], next_id });
             }
         }
-        return module_status[module_id] == 0;
+
+        for (int start_id : app_graph.start_modules) {
+            ready_modules.push(start_id);
+        }
+        sink.scheduled(makespan, agent_graph.agents);
+        return makespan;
     }
 
     // Проверка необходимости балансировки
     bool needRebalancing() {
         if (agent_graph.agents.size() <= 1) return false;
 
-        double max_load = 0, min_load = numeric_limits<double>::max();
-
-        for (const auto& agent : agent_graph.agents) {
-            max_load = max(max_load, agent.current_load);
-            min_load = min(min_load, agent.current_load);
-        }
+        double max_load = agent_graph.agents[most_loaded.top()].current_load;
+        double min_load = agent_graph.agents[least_loaded.top()].current_load;
 
         // Балансировка нужна, если разница нагрузок превышает порог
         return (max_load - min_load) > 1.0;
@@ -282,12 +931,10 @@ public:
             // Перераспределение отказавшего модуля
             int new_agent = findLeastLoadedAgent();
             if (new_agent != failed_agent) {
-                cout << "Перемещение модуля " << failed_module << " с агента "<< failed_agent << " на агента " << new_agent << endl;
+                sink.moved(event_time, failed_module, failed_agent, new_agent, false);
 
                 // Удаление из старого агента
-                auto& old_modules = agent_graph.agents[failed_agent].assigned_modules;
-                old_modules.erase(remove(old_modules.begin(), old_modules.end(), failed_module), old_modules.end());
-                agent_graph.agents[failed_agent].current_load -= app_graph.getModule(failed_module).load;
+                unassignModule(failed_module);
 
                 // Добавление новому агенту
                 assignModuleToAgent(failed_module, new_agent);
@@ -295,63 +942,605 @@ public:
         }
         else {
             // Общая балансировка нагрузки
-            // Перемещаем модули от самых загруженных к наименее загруженным
-            vector<pair<double, int>> agent_loads;
-            for (int i = 0; i < agent_graph.agents.size(); i++) {
-                agent_loads.emplace_back(agent_graph.agents[i].current_load, i);
+            // Перемещаем модули от самых загруженных к наименее загруженным:
+            // пары (k-й по убыванию, k-й по возрастанию нагрузки) снимаются с вершин куч,
+            // пока разница в паре не станет меньше порога или пока в паре нечего перенести,
+            // и возвращаются в кучи в конце. Модуль выбирается из не более DIFFUSION_CANDIDATES
+            // ожидающих запуска, так что пара стоит O(log A), а вызов - O(log A) на каждый
+            // перенесенный модуль, без просмотра пар, где перенос ничего не дал бы
+            vector<int> paired;
+            while (most_loaded.size() > 1) {
+                int loaded_agent = most_loaded.top();
+                int free_agent = least_loaded.top();
+
+                if (loaded_agent == free_agent || agent_graph.agents[loaded_agent].current_load - agent_graph.agents[free_agent].current_load < 0.5) {
+                    break;
+                }
+                for (int agent_id : { loaded_agent, free_agent }) {
+                    least_loaded.remove(agent_id);
+                    most_loaded.remove(agent_id);
+                    paired.push_back(agent_id);
+                }
+
+                // Перемещаем только не начатые модули: кандидаты - последние ожидающие,
+                // как в диффузионной балансировке, и перенос не переворачивает дисбаланс
+                double difference = agent_graph.agents[loaded_agent].current_load - agent_graph.agents[free_agent].current_load;
+                int module_to_move = pickForTransfer(loaded_agent, free_agent, difference);
+                if (module_to_move == -1) break;
+
+                sink.moved(event_time, module_to_move, loaded_agent, free_agent, true);
+
+                // Перемещение модуля
+                unassignModule(module_to_move);
+                assignModuleToAgent(module_to_move, free_agent);
+                moved_modules.push_back(module_to_move);
+                migrations++;
             }
+            for (int agent_id : paired) {
+                least_loaded.push(agent_id);
+                most_loaded.push(agent_id);
+            }
+        }
 
-            sort(agent_loads.begin(), agent_loads.end());
+        sink.rebalanced(event_time, agent_graph.agents);
+    }
 
-            int left = 0, right = agent_loads.size() - 1;
-            while (left < right) {
-                int loaded_agent = agent_loads[right].second;
-                int free_agent = agent_loads[left].second;
+    // Диффузионная балансировка после завершения модуля на агенте agent_id:
+    // агент сравнивает нагрузку только с соседями по графу агентов, и из более
+    // загруженного агента пары в менее загруженный переносится один ожидающий модуль.
+    // Рассматривается не более DIFFUSION_CANDIDATES модулей, так что шаг - O(степень агента)
+    void diffusionRebalance(int agent_id) {
+        for (int neighbor : agent_graph.agents[agent_id].neighbors) {
+            int from = agent_id, to = neighbor;
+            double difference = agent_graph.agents[from].current_load - agent_graph.agents[to].current_load;
+            if (difference < 0) {
+                swap(from, to);
+                difference = -difference;
+            }
+            if (difference <= 1.0) continue; // Тот же порог, что и в needRebalancing
 
-                if (agent_graph.agents[loaded_agent].current_load - agent_graph.agents[free_agent].current_load < 0.5) {
-                    break;
+            int module_id = pickForTransfer(from, to, difference);
+            if (module_id == -1) continue;
+
+            sink.moved(event_time, module_id, from, to, true);
+            unassignModule(module_id);
+            assignModuleToAgent(module_id, to);
+            moved_modules.push_back(module_id);
+            migrations++;
+        }
+    }
+
+    // Модуль для переноса: нагрузка ближе всего к половине разницы (тогда нагрузки
+    // пары выравниваются), и чем больше его предшественников назначено принимающему
+    // агенту, тем лучше - их данные не придется передавать
+    int pickForTransfer(int from, int to, double difference) {
+        const vector<int>& pending = pending_modules[from];
+        int best_module = -1;
+        double best_score = numeric_limits<double>::max();
+        int size = pending.size();
+        int first = max(0, size - DIFFUSION_CANDIDATES);
+        for (int i = first; i < size; i++) {
+            const Module& module = app_graph.getModule(pending[i]);
+            // Перенос не должен создавать обратный дисбаланс больше исходного
+            if (module.load >= difference) continue;
+
+            int local = 0;
+            for (int prev_id : module.prev_modules) {
+                if (module_to_agent[prev_id] == to) local++;
+            }
+            double locality = module.prev_modules.empty() ? 0 : (double)local / module.prev_modules.size();
+            double score = fabs(module.load - difference / 2) / difference - 0.5 * locality;
+            if (score < best_score) {
+                best_score = score;
+                best_module = module.id;
+            }
+        }
+        return best_module;
+    }
+};
+
+// Балансировщик с печатью событий (тесты) и без записи событий (замеры)
+typedef BasicLoadBalancer<ConsolePrinter> LoadBalancer;
+typedef BasicLoadBalancer<NullSink> QuietLoadBalancer;
+
+// Результат реального выполнения
+struct ExecutionReport {
+    double makespan = 0; // Время от запуска потоков до завершения последнего модуля, с
+    double busy_time = 0; // Суммарное время выполнения модулей всеми агентами, с
+    double idle_time = 0; // Суммарный простой агентов, с
+    long long neighbor_steals = 0; // Модули, взятые у соседей по графу агентов
+    long long remote_steals = 0; // Модули, взятые у остальных агентов
+    int completed_modules = 0; // Меньше числа модулей, если граф содержит цикл
+};
+
+// Реальное выполнение приложения: каждый агент - отдельный поток со своей
+// очередью модулей. Модуль - вычисление длительностью load * seconds_per_load.
+// Завершенный модуль уменьшает атомарные счетчики предшественников у следующих
+// модулей, обнулившийся модуль ставится в очередь агента по распределению.
+// Свободный агент берет модули сначала у соседей, затем у остальных агентов
+class ThreadedExecutor {
+private:
+    struct Worker {
+        mutex lock;
+        deque<int> tasks; // Свои модули берутся с конца, чужие - с начала
+        double busy_time = 0;
+        long long neighbor_steals = 0;
+        long long remote_steals = 0;
+        double sink = 0; // Результат вычислений, чтобы их не выбросил компилятор
+    };
+
+    const ApplicationGraph& app_graph;
+    const AgentGraph& agent_graph;
+    vector<int> module_to_agent;
+    double seconds_per_load;
+    double iterations_per_second;
+    bool stealing = true;
+
+    vector<unique_ptr<Worker>> workers;
+    unique_ptr<atomic<int>[]> remaining_deps;
+    atomic<int> completed_modules{ 0 };
+    int schedulable_modules = 0; // Сколько модулей вообще станут готовыми
+
+    // Число модулей, которые станут готовыми (проход алгоритма Кана). Модули цикла
+    // и их потомки не станут готовыми никогда, и потоки ждали бы их вечно
+    int countSchedulable() const {
+        int n = app_graph.modules.size();
+        vector<int> in_degree(n), order;
+        order.reserve(n);
+        for (const auto& module : app_graph.modules) {
+            in_degree[module.id] = module.prev_modules.size();
+            if (in_degree[module.id] == 0) order.push_back(module.id);
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+            for (int next_id : app_graph.getModule(order[i]).next_modules) {
+                if (--in_degree[next_id] == 0) order.push_back(next_id);
+            }
+        }
+        return order.size();
+    }
+
+    // Вычислительная нагрузка: цепочка зависимых операций, которую нельзя сократить
+    static double busyWork(long long iterations) {
+        double x = 1.0;
+        for (long long i = 0; i < iterations; i++) {
+            x = x * 1.0000001 + 1e-9;
+        }
+        return x;
+    }
+
+    void push(int agent_id, int module_id) {
+        Worker& worker = *workers[agent_id];
+        lock_guard<mutex> guard(worker.lock);
+        worker.tasks.push_back(module_id);
+    }
+
+    int takeOwn(int agent_id) {
+        Worker& worker = *workers[agent_id];
+        lock_guard<mutex> guard(worker.lock);
+        if (worker.tasks.empty()) return -1;
+        int module_id = worker.tasks.back();
+        worker.tasks.pop_back();
+        return module_id;
+    }
+
+    int stealFrom(int victim) {
+        Worker& worker = *workers[victim];
+        lock_guard<mutex> guard(worker.lock);
+        if (worker.tasks.empty()) return -1;
+        int module_id = worker.tasks.front();
+        worker.tasks.pop_front();
+        return module_id;
+    }
+
+    int steal(int agent_id, mt19937& gen) {
+        Worker& worker = *workers[agent_id];
+        const vector<int>& neighbors = agent_graph.agents[agent_id].neighbors;
+        if (!neighbors.empty()) {
+            int first = gen() % neighbors.size();
+            for (size_t i = 0; i < neighbors.size(); i++) {
+                int module_id = stealFrom(neighbors[(first + i) % neighbors.size()]);
+                if (module_id != -1) {
+                    worker.neighbor_steals++;
+                    return module_id;
                 }
+            }
+        }
+        int n = workers.size();
+        int first = gen() % n;
+        for (int i = 0; i < n; i++) {
+            int victim = (first + i) % n;
+            if (victim == agent_id) continue;
+            int module_id = stealFrom(victim);
+            if (module_id != -1) {
+                worker.remote_steals++;
+                return module_id;
+            }
+        }
+        return -1;
+    }
 
-                // Находим модуль для перемещения
-                int module_to_move = -1;
-                for (int module_id : agent_graph.agents[loaded_agent].assigned_modules) {
-                    if (module_status[module_id] == 0) { // Перемещаем только не начатые модули
-                        module_to_move = module_id;
-                        break;
-                    }
+    void work(int agent_id) {
+        Worker& worker = *workers[agent_id];
+        mt19937 gen(agent_id + 1);
+
+        while (completed_modules.load(memory_order_acquire) < schedulable_modules) {
+            int module_id = takeOwn(agent_id);
+            if (module_id == -1 && stealing) module_id = steal(agent_id, gen);
+            if (module_id == -1) {
+                this_thread::yield();
+                continue;
+            }
+
+            const Module& module = app_graph.getModule(module_id);
+            auto start = chrono::high_resolution_clock::now();
+            worker.sink += busyWork((long long)(module.load * seconds_per_load * iterations_per_second));
+            worker.busy_time += chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+            for (int next_id : module.next_modules) {
+                if (remaining_deps[next_id].fetch_sub(1, memory_order_acq_rel) == 1) {
+                    push(module_to_agent[next_id], next_id);
                 }
+            }
+            completed_modules.fetch_add(1, memory_order_release);
+        }
+    }
+
+public:
+    ThreadedExecutor(const ApplicationGraph& app, const AgentGraph& agents, const vector<int>& placement, double seconds_per_load)
+        : app_graph(app), agent_graph(agents), module_to_agent(placement), seconds_per_load(seconds_per_load) {
+        iterations_per_second = calibrate();
+    }
+
+    void setStealing(bool enabled) { stealing = enabled; }
+
+    // Число итераций вычислительной нагрузки в секунду (лучшее из нескольких замеров)
+    static double calibrate() {
+        const long long iterations = 1 << 22;
+        double best = numeric_limits<double>::max();
+        double sink = 0;
+        for (int attempt = 0; attempt < 5; attempt++) {
+            auto start = chrono::high_resolution_clock::now();
+            sink += busyWork(iterations);
+            best = min(best, chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+        }
+        return sink > 0 ? iterations / best : 0;
+    }
+
+    ExecutionReport run() {
+        int total_modules = app_graph.modules.size();
+        int agent_count = agent_graph.agents.size();
+
+        workers.clear();
+        for (int i = 0; i < agent_count; i++) {
+            workers.emplace_back(new Worker());
+        }
+        remaining_deps.reset(new atomic<int>[total_modules]);
+        for (const auto& module : app_graph.modules) {
+            remaining_deps[module.id].store(module.prev_modules.size(), memory_order_relaxed);
+            if (module.prev_modules.empty()) push(module_to_agent[module.id], module.id);
+        }
+        completed_modules.store(0);
+        schedulable_modules = countSchedulable();
+
+        auto start = chrono::high_resolution_clock::now();
+        vector<thread> threads;
+        for (int i = 0; i < agent_count; i++) {
+            threads.emplace_back(&ThreadedExecutor::work, this, i);
+        }
+        for (auto& t : threads) t.join();
+
+        ExecutionReport report;
+        report.makespan = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        for (const auto& worker : workers) {
+            report.busy_time += worker->busy_time;
+            report.idle_time += report.makespan - worker->busy_time;
+            report.neighbor_steals += worker->neighbor_steals;
+            report.remote_steals += worker->remote_steals;
+        }
+        report.completed_modules = completed_modules.load();
+        return report;
+    }
+};
+
+// Модель отказов агентов
+struct FaultModel {
+    double mtbf = 0; // Среднее время работы агента до отказа (0 - без отказов)
+    vector<double> agent_mtbf; // То же для каждого агента; если пусто - у всех mtbf
+    double mean_repair = 0; // Среднее время восстановления агента
+    double correlation = 0; // Вероятность, что отказ агента выводит из строя и соседа
+
+    double mtbfOf(int agent_id) const {
+        return agent_mtbf.empty() ? mtbf : agent_mtbf[agent_id];
+    }
+};
+
+// Способы восстановления после отказа
+enum Recovery {
+    RESTART, // Модуль выполняется заново на другом агенте
+    CHECKPOINT, // Модуль продолжается с последней контрольной точки
+    REPLICATION // Модуль выполняется двумя агентами, результат - от первого завершившего
+};
+
+// Результат выполнения с отказами
+struct FaultReport {
+    double makespan = 0;
+    int failures = 0; // Число отказов агентов
+    double lost_work = 0; // Потерянная из-за отказов работа
+    double checkpoint_time = 0; // Время на запись контрольных точек
+    double replica_work = 0; // Работа отмененных копий модулей
+};
+
+// Дискретно-событийное выполнение распределенного приложения с отказами агентов.
+// Время до отказа и время восстановления распределены экспоненциально;
+// отказ с вероятностью correlation выводит из строя и каждого соседа агента.
+// Модули отказавшего агента (выполняемый и ожидающие) переходят к работающим агентам
+class FaultSimulator {
+private:
+    enum EventType { COMPLETE, FAIL, REPAIR };
+
+    struct Event {
+        double time;
+        EventType type;
+        int agent_id;
+        int epoch; // Событие устарело, если эпоха агента с тех пор изменилась
+        bool operator>(const Event& other) const { return time > other.time; }
+    };
+
+    const ApplicationGraph& app_graph;
+    const AgentGraph& agent_graph;
+    vector<int> module_to_agent;
+    FaultModel model;
+    Recovery recovery = RESTART;
+    double checkpoint_interval = 1.0; // Работа между контрольными точками
+    double checkpoint_cost = 0.1; // Время записи контрольной точки
+    mt19937 rng;
+
+    // Агенты
+    vector<char> agent_up;
+    vector<int> running; // Выполняемый модуль (-1 если свободен)
+    vector<double> run_start;
+    vector<int> run_epoch; // Меняется при отказе и отмене копии
+    vector<int> fail_epoch; // Меняется при каждом отказе
+    vector<deque<int>> agent_queues;
+
+    // Модули
+    vector<int> remaining_deps;
+    vector<double> progress; // Сохраненная (по контрольным точкам) работа
+    vector<char> done;
+    vector<int> queued_copies; // Сколько копий модуля ждут в очередях
+    vector<int> copy_agent; // Агенты, выполняющие копии модуля: 2 на модуль
+
+    priority_queue<Event, vector<Event>, greater<Event>> events;
+    FaultReport report;
+
+    double exponential(double mean) {
+        return exponential_distribution<double>(1.0 / mean)(rng);
+    }
+
+    // Число контрольных точек при выполнении оставшейся работы
+    int checkpointsFor(double work) const {
+        return max(0, (int)ceil(work / checkpoint_interval) - 1);
+    }
+
+    // Работающий агент с наименьшей очередью (или исходный, если все отказали)
+    int liveAgent(int preferred) const {
+        if (agent_up[preferred]) return preferred;
+        int best = preferred;
+        size_t best_backlog = numeric_limits<size_t>::max();
+        for (size_t i = 0; i < agent_up.size(); i++) {
+            if (agent_up[i] && backlog(i) < best_backlog) {
+                best_backlog = backlog(i);
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    void enqueue(int module_id, int agent_id, double now) {
+        agent_id = liveAgent(agent_id);
+        agent_queues[agent_id].push_back(module_id);
+        queued_copies[module_id]++;
+        startNext(agent_id, now);
+    }
 
-                if (module_to_move != -1) {
-                    cout << "Балансировка: перемещение модуля " << module_to_move << " с агента " << loaded_agent << " на агента " << free_agent << endl;
+    size_t backlog(int agent_id) const {
+        return agent_queues[agent_id].size() + (running[agent_id] != -1);
+    }
 
-                    // Перемещение модуля
-                    auto& old_modules = agent_graph.agents[loaded_agent].assigned_modules;
-                    old_modules.erase(remove(old_modules.begin(), old_modules.end(), module_to_move), old_modules.end());
-                    agent_graph.agents[loaded_agent].current_load -= app_graph.getModule(module_to_move).load;
+    bool isNeighbor(int agent_id, int other) const {
+        const vector<int>& neighbors = agent_graph.agents[agent_id].neighbors;
+        return find(neighbors.begin(), neighbors.end(), other) != neighbors.end();
+    }
 
-                    assignModuleToAgent(module_to_move, free_agent);
+    // Агент для копии модуля: наименее загруженный работающий сосед. При коррелированных
+    // отказах соседи основного агента падают вместе с ним, поэтому копия идет к соседу
+    // соседа вне этой группы, а к соседу - только если таких нет.
+    // -1, если работающих кандидатов нет: копия на том же агенте ничего не защищает
+    int replicaAgent(int primary) const {
+        const vector<int>& neighbors = agent_graph.agents[primary].neighbors;
+        int best = -1;
+        if (model.correlation > 0) {
+            for (int neighbor : neighbors) {
+                for (int candidate : agent_graph.agents[neighbor].neighbors) {
+                    if (candidate == primary || !agent_up[candidate] || isNeighbor(primary, candidate)) continue;
+                    if (best == -1 || backlog(candidate) < backlog(best)) best = candidate;
                 }
+            }
+            if (best != -1) return best;
+        }
+        for (int neighbor : neighbors) {
+            if (agent_up[neighbor] && (best == -1 || backlog(neighbor) < backlog(best))) best = neighbor;
+        }
+        return best;
+    }
+
+    // Модуль готов: все предшественники завершены
+    void release(int module_id, double now) {
+        int agent_id = liveAgent(module_to_agent[module_id]);
+        enqueue(module_id, agent_id, now);
+        if (recovery == REPLICATION) {
+            int replica = replicaAgent(agent_id);
+            if (replica != -1) enqueue(module_id, replica, now);
+        }
+    }
+
+    void startNext(int agent_id, double now) {
+        while (agent_up[agent_id] && running[agent_id] == -1 && !agent_queues[agent_id].empty()) {
+            int module_id = agent_queues[agent_id].front();
+            agent_queues[agent_id].pop_front();
+            queued_copies[module_id]--;
+            if (done[module_id]) continue;
+
+            int slot = copy_agent[2 * module_id] == -1 ? 0 : 1;
+            copy_agent[2 * module_id + slot] = agent_id;
+            running[agent_id] = module_id;
+            run_start[agent_id] = now;
+
+            double work = app_graph.getModule(module_id).load - progress[module_id];
+            double duration = work;
+            if (recovery == CHECKPOINT) duration += checkpointsFor(work) * checkpoint_cost;
+            events.push({ now + duration, COMPLETE, agent_id, run_epoch[agent_id] });
+        }
+    }
+
+    // Агент перестает выполнять модуль; возвращает время, которое он на него потратил
+    double stopCopy(int agent_id, double now) {
+        int module_id = running[agent_id];
+        for (int slot = 0; slot < 2; slot++) {
+            if (copy_agent[2 * module_id + slot] == agent_id) copy_agent[2 * module_id + slot] = -1;
+        }
+        running[agent_id] = -1;
+        run_epoch[agent_id]++;
+        return now - run_start[agent_id];
+    }
+
+    void complete(int agent_id, double now) {
+        int module_id = running[agent_id];
+        double work = app_graph.getModule(module_id).load - progress[module_id];
+        if (recovery == CHECKPOINT) report.checkpoint_time += checkpointsFor(work) * checkpoint_cost;
+        stopCopy(agent_id, now);
+
+        done[module_id] = 1;
+        report.makespan = now;
+
+        // Вторая копия больше не нужна
+        int other = max(copy_agent[2 * module_id], copy_agent[2 * module_id + 1]);
+        if (other != -1) {
+            report.replica_work += stopCopy(other, now);
+            startNext(other, now);
+        }
+
+        for (int next_id : app_graph.getModule(module_id).next_modules) {
+            if (--remaining_deps[next_id] == 0) release(next_id, now);
+        }
+        startNext(agent_id, now);
+    }
+
+    void fail(int agent_id, double now, bool spread) {
+        agent_up[agent_id] = 0;
+        fail_epoch[agent_id]++;
+        report.failures++;
+
+        if (running[agent_id] != -1) {
+            int module_id = running[agent_id];
+            double elapsed = stopCopy(agent_id, now);
+            double lost = elapsed;
+            if (recovery == CHECKPOINT) {
+                // Сохранена работа всех завершенных интервалов (каждый - с записью точки)
+                double work = app_graph.getModule(module_id).load - progress[module_id];
+                int saved = min(checkpointsFor(work), (int)(elapsed / (checkpoint_interval + checkpoint_cost)));
+                progress[module_id] += saved * checkpoint_interval;
+                report.checkpoint_time += saved * checkpoint_cost;
+                lost = elapsed - saved * (checkpoint_interval + checkpoint_cost);
+            }
+            report.lost_work += lost;
+
+            bool copy_alive = queued_copies[module_id] > 0 || copy_agent[2 * module_id] != -1 || copy_agent[2 * module_id + 1] != -1;
+            if (!copy_alive) enqueue(module_id, agent_id, now);
+        }
+
+        // Ожидающие модули переходят к работающим агентам
+        deque<int> waiting;
+        waiting.swap(agent_queues[agent_id]);
+        for (int module_id : waiting) {
+            queued_copies[module_id]--;
+            if (!done[module_id]) enqueue(module_id, agent_id, now);
+        }
 
-                left++;
-                right--;
+        events.push({ now + exponential(model.mean_repair), REPAIR, agent_id, fail_epoch[agent_id] });
+
+        if (spread) {
+            for (int neighbor : agent_graph.agents[agent_id].neighbors) {
+                if (agent_up[neighbor] && uniform_real_distribution<double>(0, 1)(rng) < model.correlation) {
+                    fail(neighbor, now, false);
+                }
             }
         }
+    }
 
-        printDistribution();
+    void scheduleFailure(int agent_id, double now) {
+        double mtbf = model.mtbfOf(agent_id);
+        if (mtbf > 0) events.push({ now + exponential(mtbf), FAIL, agent_id, fail_epoch[agent_id] });
     }
 
-    // Вывод текущего распределения
-    void printDistribution() {
-        cout << "\nТекущее распределение нагрузки:" << endl;
-        for (const auto& agent : agent_graph.agents) {
-            cout << "Агент " << agent.id << ": нагрузка=" << agent.current_load<< ", модули=[";
-            for (size_t i = 0; i < agent.assigned_modules.size(); i++) {
-                cout << agent.assigned_modules[i];
-                if (i < agent.assigned_modules.size() - 1) cout << ", ";
+public:
+    FaultSimulator(const ApplicationGraph& app, const AgentGraph& agents, const vector<int>& placement, unsigned seed)
+        : app_graph(app), agent_graph(agents), module_to_agent(placement), rng(seed) {}
+
+    void setFaultModel(const FaultModel& fault_model) { model = fault_model; }
+    void setRecovery(Recovery strategy) { recovery = strategy; }
+    void setCheckpoints(double interval, double cost) {
+        checkpoint_interval = interval;
+        checkpoint_cost = cost;
+    }
+
+    FaultReport run() {
+        int total_modules = app_graph.modules.size();
+        int agent_count = agent_graph.agents.size();
+
+        agent_up.assign(agent_count, 1);
+        running.assign(agent_count, -1);
+        run_start.assign(agent_count, 0);
+        run_epoch.assign(agent_count, 0);
+        fail_epoch.assign(agent_count, 0);
+        agent_queues.assign(agent_count, deque<int>());
+        remaining_deps.resize(total_modules);
+        progress.assign(total_modules, 0);
+        done.assign(total_modules, 0);
+        queued_copies.assign(total_modules, 0);
+        copy_agent.assign(2 * total_modules, -1);
+        events = decltype(events)();
+        report = FaultReport();
+
+        for (int i = 0; i < agent_count; i++) {
+            scheduleFailure(i, 0);
+        }
+        for (const auto& module : app_graph.modules) {
+            remaining_deps[module.id] = module.prev_modules.size();
+            if (module.prev_modules.empty()) release(module.id, 0);
+        }
+
+        int completed_modules = 0;
+        while (!events.empty()) {
+            Event event = events.top();
+            events.pop();
+            int agent_id = event.agent_id;
+
+            if (event.type == COMPLETE) {
+                if (event.epoch != run_epoch[agent_id]) continue;
+                complete(agent_id, event.time);
+                if (++completed_modules == total_modules) break;
+            }
+            else if (event.type == FAIL) {
+                if (event.epoch == fail_epoch[agent_id] && agent_up[agent_id]) fail(agent_id, event.time, true);
+            }
+            else if (event.epoch == fail_epoch[agent_id]) {
+                agent_up[agent_id] = 1;
+                scheduleFailure(agent_id, event.time);
+                startNext(agent_id, event.time);
             }
-            cout << "]" << endl;
         }
-        cout << endl;
+        return report;
     }
 };
 
@@ -461,8 +1650,665 @@ void test3() {
     balancer.executeApplication();
 }
 
-int main() {
+// Случайный слоистый граф: модули слоя зависят от 1-3 модулей предыдущего слоя
+ApplicationGraph layeredGraph(int modules, int width, mt19937& gen) {
+    ApplicationGraph app;
+    uniform_real_distribution<double> load(0.0, 3.0);
+    uniform_int_distribution<int> fan_in(1, 3);
+    for (int i = 0; i < modules; i++) {
+        app.addModule(i, load(gen));
+    }
+    for (int i = width; i < modules; i++) {
+        int layer_start = i / width * width;
+        uniform_int_distribution<int> prev(layer_start - width, layer_start - 1);
+        for (int k = fan_in(gen); k > 0; k--) {
+            app.addDependency(prev(gen), i);
+        }
+    }
+    return app;
+}
+
+// Модули со случайной нагрузкой 0..3
+ApplicationGraph randomLoads(int modules, mt19937& gen) {
+    ApplicationGraph app;
+    uniform_real_distribution<double> load(0.0, 3.0);
+    for (int i = 0; i < modules; i++) {
+        app.addModule(i, load(gen));
+    }
+    return app;
+}
+
+// Fork-join: stages этапов, в каждом width параллельных модулей между
+// модулем разветвления и модулем слияния (слияние этапа - разветвление следующего)
+ApplicationGraph forkJoinGraph(int stages, int width, mt19937& gen) {
+    ApplicationGraph app = randomLoads(1 + stages * (width + 1), gen);
+    int fork = 0;
+    for (int stage = 0; stage < stages; stage++) {
+        int join = fork + width + 1;
+        for (int i = fork + 1; i < join; i++) {
+            app.addDependency(fork, i);
+            app.addDependency(i, join);
+        }
+        fork = join;
+    }
+    return app;
+}
+
+// БПФ: points входов (округляется вверх до степени двойки) и log2(points) уровней
+// "бабочек"; модуль уровня l+1 зависит от модулей l с номерами i и i ^ 2^l
+ApplicationGraph fftGraph(int points, mt19937& gen) {
+    int levels = 0;
+    while ((1 << levels) < points) levels++;
+    points = 1 << levels;
+    ApplicationGraph app = randomLoads((levels + 1) * points, gen);
+    for (int level = 0; level < levels; level++) {
+        for (int i = 0; i < points; i++) {
+            int to = (level + 1) * points + i;
+            app.addDependency(level * points + i, to);
+            app.addDependency(level * points + (i ^ (1 << level)), to);
+        }
+    }
+    return app;
+}
+
+// Метод Гаусса для матрицы n x n: на шаге k выбор ведущего элемента (k, k),
+// затем обновление столбцов j > k. Обновление (k, j) зависит от ведущего
+// элемента шага k и от обновления (k-1, j); ведущий элемент k+1 - от обновления (k, k+1)
+ApplicationGraph gaussianGraph(int n, mt19937& gen) {
+    // Номера модулей шага k: id[k][j] для j >= k
+    vector<vector<int>> id(n, vector<int>(n, -1));
+    int count = 0;
+    for (int k = 0; k < n; k++) {
+        for (int j = k; j < n; j++) id[k][j] = count++;
+    }
+    ApplicationGraph app = randomLoads(count, gen);
+    for (int k = 0; k < n; k++) {
+        for (int j = k + 1; j < n; j++) {
+            app.addDependency(id[k][k], id[k][j]);
+            if (k > 0) app.addDependency(id[k - 1][j], id[k][j]);
+        }
+        if (k > 0) app.addDependency(id[k - 1][k], id[k][k]);
+    }
+    return app;
+}
+
+// Случайный граф Эрдеша-Реньи: каждая пара i < j соединена с вероятностью,
+// дающей в среднем average_degree следующих модулей. Пары перебираются
+// геометрическими пропусками, так что построение - O(V + E).
+// При average_degree <= 0 связей нет (геометрическое распределение требует p > 0)
+ApplicationGraph randomGraph(int modules, double average_degree, mt19937& gen) {
+    ApplicationGraph app = randomLoads(modules, gen);
+    double p = min(1.0, 2.0 * average_degree / max(1, modules - 1));
+    if (!(p > 0)) return app;
+    geometric_distribution<long long> skip(p);
+    for (int i = 0; i < modules; i++) {
+        for (long long j = i + 1 + skip(gen); j < modules; j += 1 + skip(gen)) {
+            app.addDependency(i, j);
+        }
+    }
+    return app;
+}
+
+AgentGraph completeTopology(int agent_count) {
+    AgentGraph agents;
+    for (int i = 0; i < agent_count; i++) {
+        agents.addAgent(i);
+    }
+    for (int i = 0; i < agent_count; i++) {
+        for (int j = i + 1; j < agent_count; j++) {
+            agents.addConnection(i, j);
+        }
+    }
+    return agents;
+}
+
+// Звезда: агент 0 соединен со всеми остальными
+AgentGraph starTopology(int agent_count) {
+    AgentGraph agents;
+    for (int i = 0; i < agent_count; i++) {
+        agents.addAgent(i);
+    }
+    for (int i = 1; i < agent_count; i++) {
+        agents.addConnection(0, i);
+    }
+    return agents;
+}
+
+AgentGraph ringTopology(int agent_count) {
+    AgentGraph agents;
+    for (int i = 0; i < agent_count; i++) {
+        agents.addAgent(i);
+    }
+    if (agent_count == 2) agents.addConnection(0, 1);
+    if (agent_count > 2) {
+        for (int i = 0; i < agent_count; i++) {
+            agents.addConnection(i, (i + 1) % agent_count);
+        }
+    }
+    return agents;
+}
+
+// Решетка rows x cols, агент r * cols + c соединен с соседями по строке и столбцу
+AgentGraph meshTopology(int rows, int cols) {
+    AgentGraph agents;
+    for (int i = 0; i < rows * cols; i++) {
+        agents.addAgent(i);
+    }
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            if (c + 1 < cols) agents.addConnection(r * cols + c, r * cols + c + 1);
+            if (r + 1 < rows) agents.addConnection(r * cols + c, (r + 1) * cols + c);
+        }
+    }
+    return agents;
+}
+
+// Событийное выполнение большого графа без печати, отказов и балансировки
+void benchExecution() {
+    const int modules = 1000000, width = 1000, agent_count = 64;
+
+    mt19937 gen(12345);
+    ApplicationGraph app = layeredGraph(modules, width, gen);
+    AgentGraph agents = ringTopology(agent_count);
+
+    // Нижние оценки времени: общая работа / число агентов и критический путь
+    // (зависимости идут только к большим номерам, так что номера - топологический порядок)
+    double total_work = 0, critical_path = 0;
+    vector<double> finish(modules, 0);
+    for (const auto& module : app.modules) {
+        double start = 0;
+        for (int prev_id : module.prev_modules) start = max(start, finish[prev_id]);
+        finish[module.id] = start + module.load;
+        total_work += module.load;
+        critical_path = max(critical_path, finish[module.id]);
+    }
+
+    QuietLoadBalancer balancer;
+    balancer.setFailureRate(0);
+    balancer.setRebalancing(false);
+    balancer.setSeed(1);
+
+    auto start = chrono::high_resolution_clock::now();
+    balancer.initializeGraphs(app, agents);
+    balancer.initialDistribution();
+    auto distributed = chrono::high_resolution_clock::now();
+    double makespan = balancer.executeApplication();
+    auto end = chrono::high_resolution_clock::now();
+
+    cout << "Модулей: " << modules << ", агентов: " << agent_count << endl;
+    cout << "Время выполнения (модельное): " << makespan << endl;
+    cout << "Нижняя оценка: работа/агенты = " << total_work / agent_count << ", критический путь = " << critical_path << endl;
+    cout << "Распределение: " << chrono::duration<double>(distributed - start).count() << " с" << endl;
+    cout << "Моделирование: " << chrono::duration<double>(end - distributed).count() << " с" << endl;
+}
+
+// Сравнение жадного распределения со списочными HEFT и CPOP на случайных
+// слоистых графах; агенты соединены в кольцо, передача данных стоит времени
+void benchScheduling() {
+    const int agent_count = 16;
+    const double comm_per_hop = 0.5;
+    const int sizes[] = { 1000, 10000, 100000 };
+
+    AgentGraph agents = ringTopology(agent_count);
+
+    cout << "Агентов: " << agent_count << " (кольцо), передача: " << comm_per_hop << " за связь" << endl;
+    for (int modules : sizes) {
+        mt19937 gen(modules);
+        ApplicationGraph app = layeredGraph(modules, 50, gen);
+        cout << "\nМодулей: " << modules << endl;
+
+        for (int method = 0; method < 3; method++) {
+            QuietLoadBalancer balancer;
+            balancer.setFailureRate(0);
+            balancer.setRebalancing(false);
+            balancer.setCommCost(comm_per_hop);
+            balancer.initializeGraphs(app, agents);
+
+            auto start = chrono::high_resolution_clock::now();
+            double planned = 0;
+            if (method == 0) balancer.initialDistribution();
+            if (method == 1) planned = balancer.heftDistribution();
+            if (method == 2) planned = balancer.cpopDistribution();
+            auto end = chrono::high_resolution_clock::now();
+            double makespan = balancer.executeApplication();
+
+            const char* names[] = { "жадное", "HEFT", "CPOP" };
+            cout << "  " << names[method] << ": время выполнения " << makespan;
+            if (method > 0) cout << " (план " << planned << ")";
+            cout << ", планирование " << chrono::duration<double>(end - start).count() << " с" << endl;
+        }
+    }
+}
+
+// Доступ к состоянию модулей, как в цикле выполнения: проверка статусов
+// предшественников и запись агента, статуса и времени завершения
+template <class IntState, class TimeState>
+double stateAccessPass(const ApplicationGraph& app, IntState& agent_of, IntState& status, TimeState& finish) {
+    double checksum = 0;
+    for (const auto& module : app.modules) {
+        double start = 0;
+        for (int prev_id : module.prev_modules) {
+            if (status[prev_id] == 2) start = max(start, finish[prev_id]);
+        }
+        agent_of[module.id] = module.id & 63;
+        status[module.id] = 2;
+        finish[module.id] = start + module.load;
+        checksum += finish[module.id];
+    }
+    return checksum;
+}
+
+// Микробенчмарк структур состояния: хеш-таблицы против плотных массивов,
+// удаление из списков агентов через erase(remove) против перестановки с последним.
+// Сравниваются только шаблоны доступа на синтетическом проходе, а не балансировщик
+// до и после перехода на массивы; балансировщик замеряется последней строкой
+// и только в текущей раскладке
+void benchStructures() {
+    const int sizes[] = { 100000, 1000000 };
+    const int agent_count = 64, passes = 5;
+
+    for (int modules : sizes) {
+        mt19937 gen(modules);
+        ApplicationGraph app = layeredGraph(modules, 1000, gen);
+        cout << "Модулей: " << modules << endl;
+
+        unordered_map<int, int> map_agent, map_status;
+        unordered_map<int, double> map_finish;
+        auto start = chrono::high_resolution_clock::now();
+        double map_sum = 0;
+        for (int pass = 0; pass < passes; pass++) {
+            map_status.clear();
+            map_sum += stateAccessPass(app, map_agent, map_status, map_finish);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double map_time = chrono::duration<double>(end - start).count() / passes;
+
+        vector<int> dense_agent(modules), dense_status(modules);
+        vector<double> dense_finish(modules);
+        start = chrono::high_resolution_clock::now();
+        double dense_sum = 0;
+        for (int pass = 0; pass < passes; pass++) {
+            fill(dense_status.begin(), dense_status.end(), 0);
+            dense_sum += stateAccessPass(app, dense_agent, dense_status, dense_finish);
+        }
+        end = chrono::high_resolution_clock::now();
+        double dense_time = chrono::duration<double>(end - start).count() / passes;
+
+        cout << "  [микробенчмарк доступа] состояние: unordered_map " << map_time * 1e9 / modules << " нс/модуль, массивы "
+            << dense_time * 1e9 / modules << " нс/модуль" << (map_sum == dense_sum ? "" : " (расхождение!)") << endl;
+
+        // Удаление всех модулей из списков агентов в случайном порядке
+        // (на миллионе модулей erase(remove) слишком долог - только первые 1e5)
+        int removals = min(modules, 100000);
+        vector<int> order(modules);
+        for (int i = 0; i < modules; i++) order[i] = i;
+        shuffle(order.begin(), order.end(), gen);
+
+        vector<vector<int>> lists(agent_count);
+        for (int i = 0; i < modules; i++) lists[i % agent_count].push_back(i);
+        start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < removals; i++) {
+            auto& list = lists[order[i] % agent_count];
+            list.erase(remove(list.begin(), list.end(), order[i]), list.end());
+        }
+        end = chrono::high_resolution_clock::now();
+        double erase_time = chrono::duration<double>(end - start).count();
+
+        vector<int> slot(modules);
+        for (auto& list : lists) list.clear();
+        for (int i = 0; i < modules; i++) {
+            slot[i] = lists[i % agent_count].size();
+            lists[i % agent_count].push_back(i);
+        }
+        start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < removals; i++) {
+            auto& list = lists[order[i] % agent_count];
+            int last = list.back();
+            list[slot[order[i]]] = last;
+            slot[last] = slot[order[i]];
+            list.pop_back();
+        }
+        end = chrono::high_resolution_clock::now();
+        double swap_time = chrono::duration<double>(end - start).count();
+
+        cout << "  [микробенчмарк доступа] удаление из списка агента: erase(remove) " << erase_time * 1e9 / removals
+            << " нс, перестановка с последним " << swap_time * 1e9 / removals << " нс" << endl;
+
+        // Полный цикл планировщика с отказами
+        AgentGraph agents;
+        for (int i = 0; i < agent_count; i++) {
+            agents.addAgent(i);
+        }
+        QuietLoadBalancer balancer;
+        balancer.setRebalancing(false);
+        balancer.setSeed(1);
+        start = chrono::high_resolution_clock::now();
+        balancer.initializeGraphs(app, agents);
+        balancer.initialDistribution();
+        balancer.executeApplication();
+        end = chrono::high_resolution_clock::now();
+        cout << "  балансировщик (массивы), распределение и выполнение с отказами 5%: "
+            << chrono::duration<double>(end - start).count() * 1e9 / modules << " нс/модуль" << endl;
+    }
+}
+
+// Выполнение с отказами и динамической балансировкой при большом числе агентов
+void benchRebalancing() {
+    const int modules = 100000;
+    const int agent_counts[] = { 100, 1000, 4000 };
+
+    mt19937 gen(modules);
+    ApplicationGraph app = layeredGraph(modules, 1000, gen);
+    cout << "Модулей: " << modules << ", отказы 5%, балансировка включена" << endl;
+    for (int agent_count : agent_counts) {
+        AgentGraph agents;
+        for (int i = 0; i < agent_count; i++) {
+            agents.addAgent(i);
+        }
+        QuietLoadBalancer balancer;
+        balancer.setSeed(1);
+
+        auto start = chrono::high_resolution_clock::now();
+        balancer.initializeGraphs(app, agents);
+        balancer.initialDistribution();
+        double makespan = balancer.executeApplication();
+        auto end = chrono::high_resolution_clock::now();
+        cout << "  агентов " << agent_count << ": время выполнения " << makespan
+            << ", перемещений " << balancer.migrationCount() << ", "
+            << chrono::duration<double>(end - start).count() * 1e6 / modules << " мкс/модуль" << endl;
+    }
+}
+
+// Реальное многопоточное выполнение против модели: агенты - потоки в кольце,
+// распределение жадное и HEFT, с кражей модулей и без нее
+void benchThreads() {
+    const int modules = 20000;
+    const double seconds_per_load = 20e-6;
+    int agent_count = max(2u, thread::hardware_concurrency());
+
+    mt19937 gen(modules);
+    ApplicationGraph app = layeredGraph(modules, 100, gen);
+    AgentGraph agents = ringTopology(agent_count);
+
+    cout << "Модулей: " << modules << ", агентов-потоков: " << agent_count
+        << ", единица нагрузки: " << seconds_per_load * 1e6 << " мкс" << endl;
+    for (int method = 0; method < 2; method++) {
+        QuietLoadBalancer balancer;
+        balancer.setFailureRate(0);
+        balancer.setRebalancing(false);
+        balancer.initializeGraphs(app, agents);
+        if (method == 0) balancer.initialDistribution();
+        else balancer.heftDistribution();
+        vector<int> placement = balancer.placement();
+        double simulated = balancer.executeApplication() * seconds_per_load;
+
+        cout << (method == 0 ? "жадное" : "HEFT") << ": модель " << simulated << " с" << endl;
+        for (int stealing = 0; stealing < 2; stealing++) {
+            ThreadedExecutor executor(app, agents, placement, seconds_per_load);
+            executor.setStealing(stealing);
+            ExecutionReport report = executor.run();
+            if (report.completed_modules < modules) {
+                cout << "  Граф содержит цикл: выполнено " << report.completed_modules << " из " << modules << endl;
+            }
+            cout << "  " << (stealing ? "с кражей" : "без кражи") << ": " << report.makespan << " с"
+                << ", занятость " << report.busy_time / (report.makespan * agent_count) * 100 << "%"
+                << ", простой " << report.idle_time << " с"
+                << ", кражи у соседей " << report.neighbor_steals << ", у остальных " << report.remote_steals << endl;
+        }
+    }
+}
+
+// Рост времени выполнения при отказах для разных способов восстановления.
+// Среднее по нескольким запускам; рост - относительно выполнения без отказов и без защиты
+void benchFaults() {
+    const int modules = 20000, agent_count = 32, runs = 5;
+    const double mtbfs[] = { 0, 1000, 200, 50 };
+    const Recovery strategies[] = { RESTART, CHECKPOINT, REPLICATION };
+    const char* names[] = { "перезапуск", "контрольные точки", "репликация" };
+
+    mt19937 gen(modules);
+    ApplicationGraph app = layeredGraph(modules, 100, gen);
+    AgentGraph agents = ringTopology(agent_count);
+
+    QuietLoadBalancer balancer;
+    balancer.initializeGraphs(app, agents);
+    balancer.initialDistribution();
+    vector<int> placement = balancer.placement();
+
+    FaultModel model;
+    model.mean_repair = 10;
+    model.correlation = 0.3;
+    cout << "Модулей: " << modules << ", агентов: " << agent_count << " (кольцо), восстановление агента ~"
+        << model.mean_repair << ", вероятность отказа соседа " << model.correlation << endl;
+
+    double baseline = 0;
+    auto compare = [&](const string& title) {
+        cout << "\nСреднее время до отказа: " << title << endl;
+        for (int k = 0; k < 3; k++) {
+            FaultReport total;
+            for (int run = 0; run < runs; run++) {
+                FaultSimulator simulator(app, agents, placement, run + 1);
+                simulator.setFaultModel(model);
+                simulator.setRecovery(strategies[k]);
+                simulator.setCheckpoints(0.5, 0.02);
+                FaultReport report = simulator.run();
+                total.makespan += report.makespan / runs;
+                total.failures += report.failures;
+                total.lost_work += report.lost_work / runs;
+                total.checkpoint_time += report.checkpoint_time / runs;
+                total.replica_work += report.replica_work / runs;
+            }
+            if (baseline == 0) baseline = total.makespan;
+
+            cout << "  " << names[k] << ": время " << total.makespan
+                << " (+" << (total.makespan / baseline - 1) * 100 << "%)"
+                << ", отказов " << total.failures / runs << ", потеряно " << total.lost_work
+                << ", контрольные точки " << total.checkpoint_time << ", лишние копии " << total.replica_work << endl;
+        }
+    };
+
+    for (double mtbf : mtbfs) {
+        model.mtbf = mtbf;
+        compare(mtbf > 0 ? to_string((int)mtbf) : string("без отказов"));
+    }
+
+    // Неоднородные агенты: каждый четвертый ненадежен
+    model.agent_mtbf.assign(agent_count, 1000);
+    for (int i = 0; i < agent_count; i += 4) model.agent_mtbf[i] = 50;
+    compare("1000, у каждого четвертого агента 50");
+}
+
+// Набор нагрузок и топологий: каждый способ распределения и балансировки
+// на каждой паре, без печати событий. Время выполнения - модельное (makespan),
+// загрузка - доля времени, которую агенты выполняли модули. Время решений -
+// процессорное время распределения и решений балансировки без моделирования; его
+// замеряет приемник DecisionTimer, в остальных запусках часы не вызываются
+void benchSuite() {
+    const int agent_count = 64;
+    const double comm_per_hop = 0.2;
+
+    struct Workload {
+        string name;
+        ApplicationGraph app;
+    };
+    mt19937 gen(2024);
+    vector<Workload> workloads;
+    workloads.push_back({ "слоистый", layeredGraph(50000, 500, gen) });
+    workloads.push_back({ "fork-join", forkJoinGraph(100, 500, gen) });
+    workloads.push_back({ "БПФ", fftGraph(4096, gen) });
+    workloads.push_back({ "Гаусс", gaussianGraph(300, gen) });
+    workloads.push_back({ "Эрдеш-Реньи", randomGraph(50000, 2, gen) });
+
+    struct Topology {
+        string name;
+        AgentGraph agents;
+    };
+    vector<Topology> topologies;
+    topologies.push_back({ "полный", completeTopology(agent_count) });
+    topologies.push_back({ "звезда", starTopology(agent_count) });
+    topologies.push_back({ "кольцо", ringTopology(agent_count) });
+    topologies.push_back({ "решетка", meshTopology(8, agent_count / 8) });
+
+    const char* methods[] = { "жадное", "жадное+балансировка", "жадное+диффузия", "HEFT", "CPOP" };
+
+    cout << "Агентов: " << agent_count << ", передача: " << comm_per_hop << " за связь" << endl;
+    for (const auto& workload : workloads) {
+        double total_work = 0;
+        for (const auto& module : workload.app.modules) total_work += module.load;
+        cout << "\n" << workload.name << ": модулей " << workload.app.modules.size() << endl;
+
+        for (const auto& topology : topologies) {
+            cout << "  " << topology.name << endl;
+            for (int method = 0; method < 5; method++) {
+                BasicLoadBalancer<DecisionTimer> balancer;
+                balancer.setFailureRate(0);
+                balancer.setRebalancing(method == 1 || method == 2);
+                balancer.setRebalancer(method == 2 ? DIFFUSION : PAIRING);
+                balancer.setCommCost(comm_per_hop);
+                balancer.setSeed(1);
+
+                balancer.initializeGraphs(workload.app, topology.agents);
+                DecisionTimer& timer = balancer.eventSink();
+                timer.decisionStarted();
+                if (method <= 2) balancer.initialDistribution();
+                if (method == 3) balancer.heftDistribution();
+                if (method == 4) balancer.cpopDistribution();
+                timer.decisionFinished();
+                double makespan = balancer.executeApplication();
+                double decisions = timer.seconds();
+
+                cout << "    " << methods[method] << ": время выполнения " << makespan
+                    << ", загрузка " << total_work / (makespan * agent_count) * 100 << "%"
+                    << ", решения " << decisions * 1e3 << " мс ЦП" << endl;
+            }
+        }
+    }
+}
+
+// Поток вывода, отбрасывающий символы: печать форматируется, но никуда не пишется
+class DiscardBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+// Число записанных событий (сохраняет только кольцевой буфер)
+size_t recordedEvents(const NullSink&) { return 0; }
+size_t recordedEvents(const ConsolePrinter&) { return 0; }
+size_t recordedEvents(const RingRecorder& recorder) { return recorder.total(); }
+
+// Выполнение с отказами и балансировкой при разных приемниках событий
+template <class EventSink>
+double timeWithSink(const ApplicationGraph& app, const AgentGraph& agents, size_t& events) {
+    BasicLoadBalancer<EventSink> balancer;
+    balancer.setSeed(1);
+    auto start = chrono::high_resolution_clock::now();
+    balancer.initializeGraphs(app, agents);
+    balancer.initialDistribution();
+    balancer.executeApplication();
+    auto end = chrono::high_resolution_clock::now();
+    events = recordedEvents(balancer.eventSink());
+    return chrono::duration<double>(end - start).count();
+}
+
+void benchSinks() {
+    const int modules = 20000, agent_count = 16;
+    mt19937 gen(modules);
+    ApplicationGraph app = layeredGraph(modules, 200, gen);
+    AgentGraph agents = ringTopology(agent_count);
+    size_t events = 0;
+
+    cout << "Модулей: " << modules << ", агентов: " << agent_count << ", отказы 5%, балансировка включена" << endl;
+    double quiet = timeWithSink<NullSink>(app, agents, events);
+    cout << "  без записи: " << quiet << " с" << endl;
+    double ring = timeWithSink<RingRecorder>(app, agents, events);
+    cout << "  кольцевой буфер: " << ring << " с, событий " << events << endl;
+
+    DiscardBuffer discard;
+    streambuf* console = cout.rdbuf(&discard);
+    double printed = timeWithSink<ConsolePrinter>(app, agents, events);
+    cout.rdbuf(console);
+    cout << "  печать (в пустой поток): " << printed << " с" << endl;
+}
+
+// Глобальная балансировка парами против диффузионной на больших графах агентов:
+// время выполнения, число перемещений модулей и время работы балансировщика
+void benchDiffusion() {
+    const int modules = 100000;
+    const double comm_per_hop = 0.2;
+
+    mt19937 gen(modules);
+    ApplicationGraph app = layeredGraph(modules, 1000, gen);
+
+    struct Topology {
+        string name;
+        AgentGraph agents;
+    };
+    vector<Topology> topologies;
+    topologies.push_back({ "решетка 32x32", meshTopology(32, 32) });
+    topologies.push_back({ "кольцо 1024", ringTopology(1024) });
+
+    const char* methods[] = { "без балансировки", "парами", "диффузия" };
+    cout << "Модулей: " << modules << ", передача: " << comm_per_hop << " за связь" << endl;
+    for (const auto& topology : topologies) {
+        cout << topology.name << endl;
+        for (int method = 0; method < 3; method++) {
+            QuietLoadBalancer balancer;
+            balancer.setFailureRate(0);
+            balancer.setCommCost(comm_per_hop);
+            balancer.setRebalancing(method > 0);
+            balancer.setRebalancer(method == 2 ? DIFFUSION : PAIRING);
+            balancer.setSeed(1);
+
+            balancer.initializeGraphs(app, topology.agents);
+            balancer.initialDistribution();
+            auto start = chrono::high_resolution_clock::now();
+            double makespan = balancer.executeApplication();
+            auto end = chrono::high_resolution_clock::now();
+            cout << "  " << methods[method] << ": время " << makespan << ", перемещений " << balancer.migrationCount()
+                << ", моделирование " << chrono::duration<double>(end - start).count() << " с" << endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "Russian");
+    if (argc > 1 && string(argv[1]) == "bench") {
+        benchExecution();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "structures") {
+        benchStructures();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "diffusion") {
+        benchDiffusion();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "sinks") {
+        benchSinks();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "suite") {
+        benchSuite();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "faults") {
+        benchFaults();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "threads") {
+        benchThreads();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "rebalance") {
+        benchRebalancing();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "schedule") {
+        benchScheduling();
+        return 0;
+    }
     test1();
     test2();
     test3();
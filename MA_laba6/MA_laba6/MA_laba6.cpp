@@ -2,291 +2,903 @@
 #include<vector>
 #include <random>
 #include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 using namespace std;
 
-struct Card {
-	int value; //Величина карты от 0 до 12
-	int color; // Масть
-	bool adm = false; // Флаг козыря
-};
+// Набор карт - 64-битная маска: карта value масти color - бит color * 16 + value.
+// На масть приходится 16 бит (используются 13), так что сдвиг на 16 меняет масть
+typedef unsigned long long Mask;
+const Mask SUIT = 0x1FFF; // Все карты масти 0
+const Mask EACH_SUIT = 0x0001000100010001ULL; // По биту на масть: умножение размножает значения по мастям
+
+inline int cardIndex(int value, int color) { return color * 16 + value; }
+inline int cardValue(int index) { return index & 15; }
+inline int cardColor(int index) { return index >> 4; }
+inline Mask cardBit(int index) { return Mask(1) << index; }
+inline Mask suitCards(int color) { return SUIT << (color * 16); }
+
+// Встроенные инструкции подсчета бит, если они есть (в 32-битной сборке MSVC 64-битных нет)
+inline int cardCount(Mask cards) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (int)__popcnt64(cards);
+#elif defined(__GNUC__)
+	return __builtin_popcountll(cards);
+#else
+	cards = cards - ((cards >> 1) & 0x5555555555555555ULL);
+	cards = (cards & 0x3333333333333333ULL) + ((cards >> 2) & 0x3333333333333333ULL);
+	cards = (cards + (cards >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((cards * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Номер младшего бита (набор не пуст)
+inline int lowestCard(Mask cards) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, cards);
+	return (int)index;
+#elif defined(__GNUC__)
+	return __builtin_ctzll(cards);
+#else
+	return cardCount((cards & (0 - cards)) - 1);
+#endif
+}
+
+// Значения карт набора без учета масти (биты 0..12)
+inline Mask valuesOf(Mask cards) { return (cards | cards >> 16 | cards >> 32 | cards >> 48) & SUIT; }
+// Все карты с данными значениями
+inline Mask withValues(Mask values) { return values * EACH_SUIT; }
+
+// Самая младшая по величине карта набора (при равных - младшей масти)
+inline int minCard(Mask cards) {
+	return lowestCard(cards & withValues(Mask(1) << lowestCard(valuesOf(cards))));
+}
+
+// k-я по порядку карта набора
+inline int nthCard(Mask cards, int k) {
+	while (k-- > 0) cards &= cards - 1;
+	return lowestCard(cards);
+}
+
+// Карты набора hand, которые бьют карту index: старшие той же масти и, если карта не козырь, козыри
+inline Mask beaters(int index, Mask hand, int adm) {
+	int color = cardColor(index);
+	Mask result = hand & suitCards(color) & ~((cardBit(index) << 1) - 1);
+	if (color != adm) result |= hand & suitCards(adm);
+	return result;
+}
 
 struct Agent {
 	int id; //id игрока
-	vector<Card> hand; //Карты в "руке"
+	Mask hand = 0; //Карты в "руке"
 	bool leader = false;
 	bool done = false;
+	Mask shown = 0; // Карты, которые все видели у игрока: забрал со стола или открытый козырь
 };
 
 struct Table {
-	vector<Card> beaten; //Бита
-	vector<Card> atk; // Карты которые надо побить
-	vector<Card> temp; //Побитые карты в этом раунде
+	Mask beaten = 0; //Бита
+	Mask atk = 0; // Карты которые надо побить
+	Mask temp = 0; //Побитые карты в этом раунде
 };
 
 struct Bank
 {
-	vector<Card>arr;
+	int arr[52]; // Колода: номера карт, раздаются с позиции top
+	int top = 0;
 	int adm; //Козырь
+
+	bool empty() const { return top == 52; }
+	int take() { return arr[top++]; }
+};
+
+// Текущий раунд: кто атакует и кто защищается
+struct Round {
+	int atk_party = 0, def_party = 1; // Атакующая и защищающаяся команды
+	int atk_id = 0, def_id = 0; // Чья очередь в командах
+	int attacker = 0, defender = 0; // Кто играет в этом раунде (за вышедшего из игры - напарник)
+	int iter = 0; // Сколько раз в раунде отбивались
 };
-int n;
-vector<vector<Agent>> agents;
-vector<vector<Card>> cards;
-Table table;
-Bank bank;
-
-void init() {
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 13; j++) {
-			cards[i][j].value = j;
-			cards[i][j].color = i;
-		}
-	}
-	int iter = 0;
-	for (int i = 0; i < 2; i++) { //Создаем агентов
-		for (int j=0; j < 2; j++) {
-			agents[i][j].id = iter++;
-			if (j == 0) {
-				agents[i][j].leader = true;
+
+// Все состояние партии - фиксированного размера, без выделения памяти.
+// Между партиями сбрасываются только маски и флаги, колода перемешивается на месте
+struct GameState {
+	Agent agents[2][2];
+	Table table;
+	Bank bank;
+	Round round;
+	mt19937 gen;
+
+	explicit GameState(unsigned seed = random_device{}()) : gen(seed) {
+		int iter = 0;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 13; j++) {
+				bank.arr[iter++] = cardIndex(j, i);
+			}
+		}
+		iter = 0;
+		for (int i = 0; i < 2; i++) { //Создаем агентов
+			for (int j = 0; j < 2; j++) {
+				agents[i][j].id = iter++;
+				agents[i][j].leader = j == 0;
 			}
 		}
 	}
+};
 
-	random_device rd;
-	mt19937 gen(rd());
-	vector<Card> arrCards; //Мешаем и раздаем карты
-	for (const auto& row : cards) {
-		arrCards.insert(arrCards.end(), row.begin(), row.end());
-	}
-	shuffle(arrCards.begin(), arrCards.end(), gen);
-	bank.adm = arrCards.back().color; // Создаем козырь
-	for (int i = 0; i < arrCards.size(); i++) {
-		if (arrCards[i].color == bank.adm) {
-			arrCards[i].adm = true;
+void init(GameState& g) {
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			g.agents[i][j].hand = 0;
+			g.agents[i][j].done = false;
+			g.agents[i][j].shown = 0;
 		}
-
 	}
+	g.table = Table();
+	g.round = Round();
+
+	shuffle(g.bank.arr, g.bank.arr + 52, g.gen); //Мешаем и раздаем карты
+	g.bank.top = 0;
+	g.bank.adm = cardColor(g.bank.arr[51]); // Создаем козырь
 	for (int j = 0; j < 6; j++) {
-		agents[0][0].hand.push_back(arrCards.front());
-		arrCards.erase(arrCards.begin());
-		agents[0][1].hand.push_back(arrCards.front());
-		arrCards.erase(arrCards.begin());
-		agents[1][0].hand.push_back(arrCards.front());
-		arrCards.erase(arrCards.begin());
-		agents[1][1].hand.push_back(arrCards.front());
-		arrCards.erase(arrCards.begin());
-	}
-	for (int i = 0; i < arrCards.size(); i++) {
-		bank.arr.push_back(arrCards[i]);
-	}
-}
-void deleteCard(int party, int id, int i) {
-	Card temp = agents[party][id].hand[0];
-	agents[party][id].hand[0] = agents[party][id].hand[i];
-	agents[party][id].hand[i] = temp;
-	agents[party][id].hand.erase(agents[party][id].hand.begin()); // Очень странная логика удаления карты из руки
-}
-bool hasWinner() {
+		for (int i = 0; i < 2; i++) {
+			for (int k = 0; k < 2; k++) {
+				g.agents[i][k].hand |= cardBit(g.bank.take());
+			}
+		}
+	}
+}
+bool hasWinner(const GameState& g) {
 	for (int i = 0; i < 2; i++) {
-		if (agents[i][0].done == true && agents[i][1].done == true) return false;
+		if (g.agents[i][0].done == true && g.agents[i][1].done == true) return false;
 	}
 	return true;
 }
-void atack(int party, int atk_id) {
-	if (party == 0) { // тактика первой команды - класть минимальную карту
-		Card min_card = agents[party][atk_id].hand[0];
-		int min_index = 0;
-		bool flag = true;
-		for (int i = 0; i < agents[party][atk_id].hand.size(); i++) {
-			if (agents[party][atk_id].hand[i].value < min_card.value && !agents[party][atk_id].hand[i].adm) { //Сначала смотрим по не козырным картам
-				min_card = agents[party][atk_id].hand[i];
-				min_index = i;
-				flag = false; // флаг выбора карты для атаки
-			}
-		}
-		if (flag) {
-			for (int i = 0; i < agents[party][atk_id].hand.size(); i++) { // Потом среди всех
-				if (agents[party][atk_id].hand[i].value < min_card.value) {
-					min_card = agents[party][atk_id].hand[i];
-					min_index = i;
-					
-				}
-			}
+// Раздача: руки игроков и колода сразу после init
+struct Deal {
+	Agent agents[2][2];
+	Bank bank;
+};
+Deal saveDeal(const GameState& g) {
+	Deal d;
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			d.agents[i][j] = g.agents[i][j];
 		}
-		table.atk.push_back(min_card);
-		deleteCard(party, atk_id, min_index);
 	}
-	else { // тактика второй команды - класть рандомную карту (тоже тактика)
-		random_device rd;
-		mt19937 gen(rd());
-		uniform_int_distribution<> dis(0, agents[party][atk_id].hand.size()-1);
-		int card = dis(gen);
-		table.atk.push_back(agents[party][atk_id].hand[card]);
-		deleteCard(party, atk_id, card);
+	d.bank = g.bank;
+	return d;
+}
+// Та же раздача с переставленными местами: команда 1 получает руки команды 0 и ходит первой
+void mirrorDeal(GameState& g, const Deal& d) {
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			g.agents[i][j] = d.agents[i][j];
+			g.agents[i][j].hand = d.agents[1 - i][j].hand;
+		}
 	}
+	g.bank = d.bank;
+	g.table = Table();
+	g.round = Round();
+	g.round.atk_party = 1;
+	g.round.def_party = 0;
 }
-bool canBeat(int atk, bool adm_atk, int def,bool adm_def,int col_atk,int col_def) {
-	if (def > atk && col_def == col_atk )
-		return true;
-	if (adm_def && !adm_atk)
-		return true;
-	return false;
+// Номер победившей команды (партия закончена); -1, если обе команды вышли в одном раунде (ничья)
+int winner(const GameState& g) {
+	bool first = g.agents[0][0].done && g.agents[0][1].done;
+	bool second = g.agents[1][0].done && g.agents[1][1].done;
+	return first && second ? -1 : first ? 0 : 1;
 }
-bool deffend(int party, int def_id) {
-	for (int i = 0; i < agents[party][def_id].hand.size(); i++) {
-		for (int j = 0; j < table.atk.size(); j++) {
-			if (canBeat(
-					table.atk[j].value, 
-					table.atk[j].adm, 
-					agents[party][def_id].hand[i].value, 
-					agents[party][def_id].hand[i].adm, 
-					table.atk[j].color, agents[party][def_id].hand[i].color)) 
-			{
-				table.temp.push_back(table.atk[j]);
-				table.temp.push_back(agents[party][def_id].hand[i]);
-				Card temp = table.atk[0];
-				table.atk[0] = table.atk[j];
-				table.atk[j] = temp;
-				table.atk.erase(table.atk.begin());
-				deleteCard(party, def_id, i);
+// Стратегии игроков. Стратегия - класс с функциями решений (статическими, если стратегии
+// не нужно состояние; поиск хранит в объекте бюджет, счетчики и потоки):
+//   attack(g, party, id) - карта для атаки из руки игрока (рука не пуста);
+//   defend(g, party, id, atk, can) - карта из can, которой побить atk, или -1 (не бить);
+//   throwIn(g, party, id, candidates) - карта из candidates, которую подкинуть, или -1.
+// Стратегии команд - параметры шаблона движка, так что вызовы подставляются без виртуальных функций.
+// Движок получает объект стратегий; у стратегий без состояния это пустая структура
+
+// Самая младшая некозырная карта, если есть, иначе самая младшая
+inline int minPlainCard(Mask cards, int adm) {
+	Mask plain = cards & ~suitCards(adm);
+	return minCard(plain ? plain : cards);
+}
+
+// Класть и отбивать минимальной картой, подкидывать минимальную
+struct MinCard {
+	static const char* name() { return "min card"; }
+	static int attack(GameState& g, int party, int id) {
+		return minPlainCard(g.agents[party][id].hand, g.bank.adm);
+	}
+	static int defend(GameState& g, int, int, int, Mask can) {
+		return minPlainCard(can, g.bank.adm);
+	}
+	static int throwIn(GameState& g, int, int, Mask candidates) {
+		return minPlainCard(candidates, g.bank.adm);
+	}
+};
+
+// Случайная карта при каждом решении
+struct RandomCard {
+	static const char* name() { return "random card"; }
+	static int pick(GameState& g, Mask cards) {
+		uniform_int_distribution<> dis(0, cardCount(cards) - 1);
+		return nthCard(cards, dis(g.gen));
+	}
+	static int attack(GameState& g, int party, int id) { return pick(g, g.agents[party][id].hand); }
+	static int defend(GameState& g, int, int, int, Mask can) { return pick(g, can); }
+	static int throwIn(GameState& g, int, int, Mask candidates) { return pick(g, candidates); }
+};
+
+// Копить козыри: пока в колоде есть карты, козырем бьется только старшая карта
+// (валет и выше), и козыри не подкидываются
+struct TrumpHoarding {
+	static const char* name() { return "trump hoarding"; }
+	static int attack(GameState& g, int party, int id) {
+		return minPlainCard(g.agents[party][id].hand, g.bank.adm);
+	}
+	static int defend(GameState& g, int, int, int atk, Mask can) {
+		Mask plain = can & ~suitCards(g.bank.adm);
+		if (plain) return minCard(plain);
+		if (g.bank.empty() || cardValue(atk) >= 9) return minCard(can);
+		return -1;
+	}
+	static int throwIn(GameState& g, int, int, Mask candidates) {
+		Mask plain = candidates & ~suitCards(g.bank.adm);
+		if (plain) return minCard(plain);
+		return g.bank.empty() ? minCard(candidates) : -1;
+	}
+};
+
+// Подсчет карт: карты, которых нет в руке, в бите и на столе, могут быть у соперников.
+// Атакуем и подкидываем картой, которую им труднее всего побить
+struct CardCounting {
+	static const char* name() { return "card counting"; }
+	static Mask unseen(const GameState& g, int party, int id) {
+		return withValues(SUIT) & ~(g.agents[party][id].hand | g.table.beaten | g.table.atk | g.table.temp);
+	}
+	// Карта набора с наименьшей ценой: достоинство плюс число неизвестных карт, которые ее бьют.
+	// Младшая карта дешевле, но если ее есть чем побить, выгоднее отдать карту постарше
+	static int safest(const GameState& g, Mask cards, Mask unknown) {
+		int best = -1, best_cost = 1 << 30;
+		for (Mask rest = cards; rest; rest &= rest - 1) {
+			int card = lowestCard(rest);
+			int cost = cardValue(card) + cardCount(beaters(card, unknown, g.bank.adm));
+			if (cost < best_cost) {
+				best = card;
+				best_cost = cost;
 			}
 		}
+		return best;
 	}
-	if (table.atk.size() > 0) {
-		for (int j = 0; j < table.atk.size(); j++) {
-			agents[party][def_id].hand.push_back(table.atk[j]);
-		}
-		table.atk.clear();
-		for (int j = 0; j < table.temp.size(); j++) {
-			agents[party][def_id].hand.push_back(table.temp[j]);
+	static int attack(GameState& g, int party, int id) {
+		Mask hand = g.agents[party][id].hand;
+		Mask plain = hand & ~suitCards(g.bank.adm);
+		return safest(g, plain ? plain : hand, unseen(g, party, id));
+	}
+	static int defend(GameState& g, int, int, int, Mask can) {
+		return minPlainCard(can, g.bank.adm);
+	}
+	static int throwIn(GameState& g, int party, int id, Mask candidates) {
+		Mask plain = candidates & ~suitCards(g.bank.adm);
+		if (!plain && !g.bank.empty()) return -1;
+		return safest(g, plain ? plain : candidates, unseen(g, party, id));
+	}
+};
+
+// Стратегии двух команд: решение принимает стратегия команды party
+template <class First, class Second>
+struct Teams {
+	First first;
+	Second second;
+
+	explicit Teams(const First& first = First(), const Second& second = Second()) : first(first), second(second) {}
+
+	int attack(GameState& g, int party, int id) {
+		return party == 0 ? first.attack(g, party, id) : second.attack(g, party, id);
+	}
+	int defend(GameState& g, int party, int id, int atk, Mask can) {
+		return party == 0 ? first.defend(g, party, id, atk, can) : second.defend(g, party, id, atk, can);
+	}
+	int throwIn(GameState& g, int party, int id, Mask candidates) {
+		return party == 0 ? first.throwIn(g, party, id, candidates) : second.throwIn(g, party, id, candidates);
+	}
+};
+
+// Игрок кладет карту на стол
+void place(GameState& g, int party, int id, int card) {
+	g.table.atk |= cardBit(card);
+	g.agents[party][id].hand &= ~cardBit(card);
+}
+// Защищающийся бьет карту atk картой def
+void beat(GameState& g, int party, int id, int atk, int def) {
+	g.table.temp |= cardBit(atk) | cardBit(def);
+	g.table.atk &= ~cardBit(atk);
+	g.agents[party][id].hand &= ~cardBit(def);
+}
+// Защищающийся забирает все карты раунда - теперь все знают, что они у него
+void take(GameState& g, int party, int id) {
+	Mask cards = g.table.atk | g.table.temp;
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			g.agents[i][j].shown &= ~cards;
 		}
-		table.temp.clear();
-		return false; //Не смог отбить
 	}
-	for (int j = 0; j < table.temp.size(); j++) {
-		table.beaten.push_back(table.temp[j]);
+	g.agents[party][id].hand |= cards;
+	g.agents[party][id].shown |= cards;
+	g.table.atk = 0;
+	g.table.temp = 0;
+}
+// Отбился - карты раунда уходят в биту
+void discard(GameState& g) {
+	g.table.beaten |= g.table.temp;
+	g.table.temp = 0;
+}
+template <class T>
+void atack(GameState& g, T& players, int party, int atk_id) {
+	place(g, party, atk_id, players.attack(g, party, atk_id));
+}
+template <class T>
+bool deffend(GameState& g, T& players, int party, int def_id) {
+	while (g.table.atk) { // Бьем атакующие карты по порядку картами, которые выберет стратегия
+		int atk = lowestCard(g.table.atk);
+		Mask can = beaters(atk, g.agents[party][def_id].hand, g.bank.adm);
+		int def = can ? players.defend(g, party, def_id, atk, can) : -1;
+		if (def == -1) { // Одну карту не побил - забирает все карты раунда
+			take(g, party, def_id);
+			return false; //Не смог отбить
+		}
+		beat(g, party, def_id, atk, def);
 	}
-	table.temp.clear();
 	return true;
-	
-}
-bool addToTable(int party, int atk_id) {
-	bool flag = false;
-	for (int i = 0; i < agents[party][atk_id].hand.size(); i++) {
-		for (int j = 0; j < table.temp.size(); j++) {
-			if (agents[party][atk_id].hand[i].value == table.temp[j].value) {
-				table.atk.push_back(agents[party][atk_id].hand[i]);
-				deleteCard(party, atk_id, i);
-				flag = true;
-				break;
-			}
-		}
-		if (flag == false) {
-			atk_id = 1 - atk_id;
-			for (int j = 0; j < table.temp.size(); j++) {
-				if (agents[party][atk_id].hand[i].value == table.temp[j].value) {
-					table.atk.push_back(agents[party][atk_id].hand[i]);
-					deleteCard(party, atk_id, i);
-					flag = true;
-					break;
-				}
+}
+template <class T>
+bool addToTable(GameState& g, T& players, int party, int atk_id, int first = 0) {
+	// Подкидываем карту того же достоинства, что и на столе: сначала атакующий, потом его напарник
+	Mask values = withValues(valuesOf(g.table.temp));
+	for (int k = first; k < 2; k++) {
+		int id = k == 0 ? atk_id : 1 - atk_id;
+		Mask candidates = g.agents[party][id].hand & values;
+		if (candidates) {
+			int card = players.throwIn(g, party, id, candidates);
+			if (card != -1) {
+				place(g, party, id, card);
+				return true;
 			}
 		}
-		if (flag) break;
 	}
-	return flag;
+	return false;
 }
-bool play(int party_atk,int party_def,int atk_id,int def_id) {
-	if (agents[party_atk][atk_id].done) atk_id = 1 - atk_id;
-	if (agents[party_def][def_id].done) def_id = 1 - def_id;
-	atack(party_atk, atk_id);
+// Продолжение раунда с защиты: защищающийся бьет карты на столе, атакующие подкидывают
+template <class T>
+bool defendRound(GameState& g, T& players) {
+	Round& r = g.round;
 	bool def = true;
-	int iter = 0;
-	while(iter < 6) {
-		def = deffend(party_def, def_id);
+	while(true) {
+		def = deffend(g, players, r.def_party, r.defender);
 		if (!def) {
 			break;
 		}
-		if (!addToTable(party_atk, atk_id)) break;
-		iter++;
+		if (++r.iter >= 6 || !addToTable(g, players, r.atk_party, r.attacker)) break;
 	}
+	if (def) discard(g);
 	return def;
 }
-void addToHand() {
-	if (bank.arr.size() > 0) {
-		for (int i = 0; i < agents.size(); i++) {
-			for (int j = 0; j < agents[i].size(); j++) {
-				while (agents[i][j].hand.size() < 6)
-				{
-					agents[i][j].hand.push_back(bank.arr[0]);
-					bank.arr.erase(bank.arr.begin());
-				}
+template <class T>
+bool play(GameState& g, T& players) {
+	Round& r = g.round;
+	r.attacker = g.agents[r.atk_party][r.atk_id].done ? 1 - r.atk_id : r.atk_id;
+	r.defender = g.agents[r.def_party][r.def_id].done ? 1 - r.def_id : r.def_id;
+	r.iter = 0;
+	atack(g, players, r.atk_party, r.attacker);
+	return defendRound(g, players);
+}
+// Добор карт: первой добирает команда, которая атакует в следующем раунде, так что
+// порядок добора зависит от ролей, а не от номеров команд
+void addToHand(GameState& g) {
+	for (int k = 0; k < 2; k++) {
+		int i = k == 0 ? g.round.atk_party : g.round.def_party;
+		for (int j = 0; j < 2; j++) {
+			while (cardCount(g.agents[i][j].hand) < 6 && !g.bank.empty())
+			{
+				int card = g.bank.take();
+				g.agents[i][j].hand |= cardBit(card);
+				if (g.bank.empty()) g.agents[i][j].shown |= cardBit(card); // Последняя карта колоды - открытый козырь
 			}
 		}
 	}
 }
-void check() {
-	for (int i = 0; i < agents.size(); i++) {
-		for (int j = 0; j < agents[i].size(); j++) {
-			if (agents[i][j].hand.size() == 0) {
+void check(GameState& g) {
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			if (g.agents[i][j].hand == 0) {
 				//cout << "Agent " << i << " " << j << '\n';
-				agents[i][j].done = true;
+				g.agents[i][j].done = true;
 			}
 			
 		}
 	}
 }
-int main() {
-	int win1 = 0, win2=0;
-	for(int i=0;i<1000;i++)
-	{
-		agents.resize(2);
-		cards.resize(4);
-		for (int i = 0; i < 4; i++) {
-			cards[i].resize(13);
+// Конец раунда: если отбился, ход переходит к защищавшейся команде; добор карт
+void endRound(GameState& g, bool def) {
+	Round& r = g.round;
+	if (def) {
+		swap(r.atk_party, r.def_party);
+		swap(r.atk_id, r.def_id);
+	}
+	addToHand(g);
+	check(g);
+	if (g.agents[r.atk_party][r.atk_id].done) {
+		r.atk_id = 1 - r.atk_id;
+	}
+	if (g.agents[r.def_party][r.atk_id].done) {
+		r.atk_id = 1 - r.atk_id;
+	}
+}
+// Доиграть партию с начала очередного раунда; возвращает номер победившей команды или -1
+template <class T>
+int playOut(GameState& g, T& players) {
+	while (hasWinner(g)) {
+		endRound(g, play(g, players));
+	}
+	return winner(g);
+}
+// Одна партия команд со стратегиями T; возвращает номер победившей команды (0 или 1) или -1 при ничьей
+template <class T>
+int playGame(GameState& g, T& players) {
+	init(g);
+	return playOut(g, players);
+}
+// Бюджет поиска на один ход: розыгрыши и/или время (0 - без ограничения) и число потоков
+struct SearchBudget {
+	long long playouts = 1000;
+	double seconds = 0;
+	int threads = 1;
+};
+// Всего розыгрышей и время поиска (для подсчета розыгрышей в секунду)
+struct SearchStats {
+	atomic<long long> playouts{ 0 };
+	atomic<long long> microseconds{ 0 };
+};
+
+// Случайная раскладка скрытых карт, согласованная с тем, что видел игрок (party, id):
+// своя рука, стол, бита, открытый козырь и карты, которые другие игроки забрали со стола.
+// Размеры рук и колоды не меняются
+void determinize(GameState& g, int party, int id) {
+	Mask open = g.table.beaten | g.table.atk | g.table.temp | g.agents[party][id].hand;
+	if (!g.bank.empty()) open |= cardBit(g.bank.arr[51]);
+	Mask known = 0;
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			if (i != party || j != id) known |= g.agents[i][j].shown & ~open;
 		}
+	}
+	int hidden[52];
+	int n = 0;
+	for (Mask rest = withValues(SUIT) & ~open & ~known; rest; rest &= rest - 1) {
+		hidden[n++] = lowestCard(rest);
+	}
+	shuffle(hidden, hidden + n, g.gen);
+	n = 0;
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			if (i == party && j == id) continue;
+			Agent& agent = g.agents[i][j];
+			Mask hand = agent.shown & ~open;
+			for (int k = cardCount(hand); k < cardCount(agent.hand); k++) {
+				hand |= cardBit(hidden[n++]);
+			}
+			agent.hand = hand;
+		}
+	}
+	for (int k = g.bank.top; k < 51; k++) { // Открытый козырь остается последним
+		g.bank.arr[k] = hidden[n++];
+	}
+}
+
+// Поиск Монте-Карло по раскладкам (определенный поиск по информационным множествам с деревом
+// глубины 1): на каждом решении перебираем ходы по UCB1, для каждого розыгрыша заново
+// раскладываем скрытые карты и доигрываем партию стратегией Rollout за всех игроков.
+// С несколькими потоками каждый ищет независимо со своим генератором, счетчики ходов
+// складываются (распараллеливание по корню). Потоки создаются при первом решении
+// и ждут следующих решений. Бюджет и счетчики принадлежат объекту: копии (например,
+// по одной на поток серии партий) получают тот же бюджет и общие счетчики, но свои потоки
+template <class Rollout>
+class Search {
+public:
+	typedef Teams<Rollout, Rollout> Playout;
+	enum Decision { ATTACK, DEFEND, THROW_IN };
+
+	static const char* name() { return "search"; }
+
+	explicit Search(const SearchBudget& budget = SearchBudget())
+		: budget(budget), stats(make_shared<SearchStats>()) {}
+	Search(const Search& other) : budget(other.budget), stats(other.stats) {}
+	~Search() {
+		{
+			lock_guard<mutex> guard(lock);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& worker : workers) worker.join();
+	}
+
+	const SearchStats& statistics() const { return *stats; }
+
+	int attack(GameState& g, int party, int id) {
+		return choose(g, ATTACK, party, id, g.agents[party][id].hand, false);
+	}
+	int defend(GameState& g, int party, int id, int, Mask can) {
+		return choose(g, DEFEND, party, id, can, true);
+	}
+	int throwIn(GameState& g, int party, int id, Mask candidates) {
+		return choose(g, THROW_IN, party, id, candidates, true);
+	}
+
+private:
+	// Статистика ходов одного потока
+	struct Counts {
+		long long visits[53] = {};
+		long long wins[53] = {};
+	};
+
+	// Текущее решение, общее для всех потоков
+	struct Job {
+		const GameState* g = nullptr;
+		Decision kind = ATTACK;
+		int party = 0, id = 0;
+		int moves[53];
+		int n = 0;
+		chrono::high_resolution_clock::time_point deadline;
+	};
+
+	SearchBudget budget;
+	shared_ptr<SearchStats> stats;
+
+	Job job;
+	vector<Counts> counts; // По потокам
+	vector<unsigned> seeds;
+	GameState scratch{ 0 }; // Позиция розыгрышей вызывающего потока
+
+	// Пул потоков: поток t > 0 ждет новое поколение решения, ищет и отмечается в running
+	vector<thread> workers;
+	mutex lock;
+	condition_variable wake, finished;
+	long long generation = 0;
+	int running = 0;
+	bool stopping = false;
+
+	// Позиция без генератора: у каждого потока поиска свой
+	static void restore(GameState& d, const GameState& g) {
 		for (int i = 0; i < 2; i++) {
-			agents[i].resize(2);
+			for (int j = 0; j < 2; j++) {
+				d.agents[i][j] = g.agents[i][j];
+			}
 		}
-		init();
-		int atk_party = 0;
-		int def_party = 1;
-		int atk_id = 0;
-		int def_id = 0;
-		int iter = 0;
-		while (hasWinner()) {
-			//cout << iter << " " << agents[atk_party][atk_id].done << '\n';
-			if (play(atk_party, def_party, atk_id, def_id)) {
-				atk_party = 1 - atk_party;
-				def_party = 1 - def_party;
-				swap(atk_id, def_id);
+		d.table = g.table;
+		d.bank = g.bank;
+		d.round = g.round;
+	}
+
+	// Делает ход card в решении kind и доигрывает партию; 1, если выиграла команда party
+	static int playout(GameState& d, Playout& rollout, Decision kind, int party, int id, int card) {
+		bool def;
+		if (kind == ATTACK) {
+			place(d, party, id, card);
+			def = defendRound(d, rollout);
+		}
+		else if (kind == DEFEND) {
+			if (card == -1) {
+				take(d, party, id);
+				def = false;
+			}
+			else {
+				beat(d, party, id, lowestCard(d.table.atk), card);
+				def = defendRound(d, rollout);
+			}
+		}
+		else if (card != -1 || (id == d.round.attacker && addToTable(d, rollout, party, id, 1))) {
+			if (card != -1) place(d, party, id, card);
+			def = defendRound(d, rollout);
+		}
+		else { // Никто не подкинул
+			discard(d);
+			def = true;
+		}
+		endRound(d, def);
+		return playOut(d, rollout) == party;
+	}
+
+	// Розыгрыши потока t (0 - без ограничения)
+	long long share(int t) const {
+		int threads = counts.size();
+		long long total = budget.playouts;
+		return total ? max(1LL, total / threads + (t < total % threads)) : 0;
+	}
+
+	void searchThread(GameState& d, int t) {
+		Playout rollout;
+		Counts& own = counts[t];
+		long long playouts = share(t);
+		d.gen.seed(seeds[t]);
+		long long total = 0;
+		for (; !playouts || total < playouts; total++) {
+			if (budget.seconds > 0 && (total & 63) == 0 && chrono::high_resolution_clock::now() >= job.deadline) break;
+			int best = 0;
+			double best_value = -1;
+			double log_total = log((double)total + 1);
+			for (int k = 0; k < job.n; k++) {
+				if (own.visits[k] == 0) {
+					best = k;
+					break;
+				}
+				double value = (double)own.wins[k] / own.visits[k] + 0.7 * sqrt(log_total / own.visits[k]);
+				if (value > best_value) {
+					best = k;
+					best_value = value;
+				}
+			}
+			restore(d, *job.g);
+			determinize(d, job.party, job.id);
+			own.wins[best] += playout(d, rollout, job.kind, job.party, job.id, job.moves[best]);
+			own.visits[best]++;
+		}
+		stats->playouts += total;
+	}
+
+	void workerLoop(int t) {
+		GameState d(0);
+		long long seen = 0;
+		while (true) {
+			{
+				unique_lock<mutex> guard(lock);
+				wake.wait(guard, [&]() { return stopping || generation != seen; });
+				if (stopping) return;
+				seen = generation;
 			}
-			addToHand();
-			check();
-			if (agents[atk_party][atk_id].done) {
-				atk_id = 1 - atk_id;
+			searchThread(d, t);
+			{
+				lock_guard<mutex> guard(lock);
+				if (--running == 0) finished.notify_one();
 			}
-			if (agents[def_party][atk_id].done) {
-				atk_id = 1 - atk_id;
+		}
+	}
+
+	// Ход из набора cards (и отказ от хода, если decline) с наибольшим числом розыгрышей
+	int choose(GameState& g, Decision kind, int party, int id, Mask cards, bool decline) {
+		int n = 0;
+		for (; cards; cards &= cards - 1) job.moves[n++] = lowestCard(cards);
+		if (decline) job.moves[n++] = -1;
+		if (n == 1) return job.moves[0];
+
+		auto start = chrono::high_resolution_clock::now();
+		int threads = max(1, budget.threads);
+		job.g = &g;
+		job.kind = kind;
+		job.party = party;
+		job.id = id;
+		job.n = n;
+		job.deadline = start + chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double>(budget.seconds));
+		counts.assign(threads, Counts());
+		seeds.resize(threads);
+		for (int t = 0; t < threads; t++) seeds[t] = (unsigned)g.gen();
+
+		for (int t = workers.size() + 1; t < threads; t++) {
+			workers.emplace_back(&Search::workerLoop, this, t);
+		}
+		{
+			lock_guard<mutex> guard(lock);
+			running = threads - 1;
+			generation++;
+		}
+		wake.notify_all();
+		searchThread(scratch, 0);
+		{
+			unique_lock<mutex> guard(lock);
+			finished.wait(guard, [&]() { return running == 0; });
+		}
+		stats->microseconds += chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - start).count();
+
+		int best = 0;
+		long long best_visits = -1;
+		for (int k = 0; k < n; k++) {
+			long long visits = 0;
+			for (int t = 0; t < threads; t++) visits += counts[t].visits[k];
+			if (visits > best_visits) {
+				best = k;
+				best_visits = visits;
 			}
-			iter++;
 		}
-		if (agents[0][0].done && agents[0][1].done) {
+		return job.moves[best];
+	}
+};
+
+// Стратегии команд в обычной игре
+typedef Teams<MinCard, RandomCard> DefaultTeams;
+
+// Скорость игры: партий в секунду без вывода
+void bench(int games) {
+	GameState game;
+	DefaultTeams players;
+	int wins[3] = { 0, 0, 0 }; // Ничьи, победы команды 0, победы команды 1
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < games; i++) {
+		wins[playGame(game, players) + 1]++;
+	}
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+	cout << games << " games: " << seconds << " s, " << games / seconds << " games/s\n";
+	cout << wins[1] << " : " << wins[2] << ", draws " << wins[0] << '\n';
+}
+// Результат серии партий: побед команды 0 и ничьих из games
+struct Score {
+	long long games = 0;
+	long long wins = 0;
+	long long draws = 0;
+
+	// Доля очков команды 0: ничья - половина победы
+	double share() const { return (wins + 0.5 * draws) / games; }
+};
+// Серия партий на всех ядрах: у каждого потока свое состояние игры, генератор
+// со своим зерном и копия стратегий, результаты потоков складываются после завершения.
+// Каждая раздача играется дважды, второй раз с переставленными местами: первый ход
+// дает заметное преимущество, и без перестановки оно попадало бы в долю побед команды 0
+template <class T>
+Score playSeries(const T& players, long long games, int threads, unsigned seed) {
+	vector<Score> scores(threads);
+	vector<thread> workers;
+	long long deals = (games + 1) / 2;
+	for (int t = 0; t < threads; t++) {
+		workers.emplace_back([&, t]() {
+			GameState game(seed * 1000003u + t);
+			T teams(players);
+			Score local; // Считаем локально, чтобы потоки не писали в соседние ячейки
+			local.games = 2 * (deals / threads + (t < deals % threads));
+			Deal deal;
+			for (long long i = 0; i < local.games; i++) {
+				if (i % 2 == 0) {
+					init(game);
+					deal = saveDeal(game);
+				}
+				else {
+					mirrorDeal(game, deal);
+				}
+				int result = playOut(game, teams);
+				if (result == 0) local.wins++;
+				if (result == -1) local.draws++;
+			}
+			scores[t] = local;
+		});
+	}
+	Score total;
+	for (int t = 0; t < threads; t++) {
+		workers[t].join();
+		total.games += scores[t].games;
+		total.wins += scores[t].wins;
+		total.draws += scores[t].draws;
+	}
+	return total;
+}
+// 95% доверительный интервал доли очков (интервал Уилсона)
+void wilson(const Score& score, double& low, double& high) {
+	const double z = 1.959964;
+	double n = (double)score.games;
+	double p = score.share();
+	double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+	double half = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+	low = center - half;
+	high = center + half;
+}
+// Серия партий First против Second с выводом доли очков команды 0
+template <class First, class Second>
+void reportPairing(const First& first, long long games, int threads) {
+	auto start = chrono::high_resolution_clock::now();
+	Score score = playSeries(Teams<First, Second>(first), games, threads, (unsigned)hash<string>()(string(First::name()) + Second::name()));
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+	double low, high;
+	wilson(score, low, high);
+	cout << First::name() << " vs " << Second::name() << ": team 1 scores "
+		<< 100 * score.share() << "% [" << 100 * low << "%, " << 100 * high << "%], draws "
+		<< 100.0 * score.draws / score.games << "%, " << score.games / seconds << " games/s\n";
+}
+
+// Набор стратегий турнира: каждая пара играет games партий (раздачи - на обоих местах)
+template <class... All>
+struct Catalog {
+	template <class First>
+	static void row(const First& first, long long games, int threads) {
+		int order[] = { (reportPairing<First, All>(first, games, threads), 0)... };
+		(void)order;
+	}
+	template <class First>
+	static void row(long long games, int threads) {
+		row(First(), games, threads);
+	}
+	static void tournament(long long games, int threads) {
+		cout << games << " games per pairing, " << threads << " threads\n";
+		int order[] = { (row<All>(games, threads), 0)... };
+		(void)order;
+	}
+};
+typedef Catalog<MinCard, RandomCard, TrumpHoarding, CardCounting> Strategies;
+
+// Скорость розыгрышей поиска: первый ход в случайных раздачах с бюджетом по времени
+// на 1, 2, 4... threads потоках
+void benchPlayouts(double seconds, int threads) {
+	GameState game(1);
+	for (int t = 1; ; t = min(2 * t, threads)) {
+		SearchBudget budget;
+		budget.playouts = 0;
+		budget.seconds = seconds;
+		budget.threads = t;
+		Search<MinCard> search(budget);
+		for (int i = 0; i < 10; i++) {
+			init(game);
+			search.attack(game, 0, 0);
+		}
+		const SearchStats& stats = search.statistics();
+		cout << t << " threads: " << stats.playouts * 1e6 / stats.microseconds << " playouts/s\n";
+		if (t == threads) break;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 1 && string(argv[1]) == "bench") {
+		bench(argc > 2 ? stoi(argv[2]) : 1000000);
+		return 0;
+	}
+	if (argc > 1 && string(argv[1]) == "tournament") {
+		int threads = argc > 3 ? stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+		Strategies::tournament(argc > 2 ? stoll(argv[2]) : 1000000, threads);
+		return 0;
+	}
+	if (argc > 1 && string(argv[1]) == "playouts") {
+		int threads = argc > 3 ? stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+		benchPlayouts(argc > 2 ? stod(argv[2]) : 0.1, threads);
+		return 0;
+	}
+	if (argc > 1 && string(argv[1]) == "search") { // Поиск против каждой стратегии: партии, бюджет на ход, потоки
+		string limit = argc > 3 ? argv[3] : "1000";
+		SearchBudget budget;
+		if (limit.back() == 's') { // Бюджет по времени, например 0.01s
+			budget.playouts = 0;
+			budget.seconds = stod(limit);
+		}
+		else {
+			budget.playouts = stoll(limit);
+		}
+		budget.threads = argc > 4 ? stoi(argv[4]) : max(1u, thread::hardware_concurrency());
+		Search<MinCard> search(budget);
+		Strategies::row(search, argc > 2 ? stoll(argv[2]) : 200, 1);
+		const SearchStats& stats = search.statistics();
+		cout << stats.playouts << " playouts, " << stats.playouts * 1e6 / stats.microseconds << " playouts/s\n";
+		return 0;
+	}
+	GameState game;
+	DefaultTeams players;
+	int win1 = 0, win2=0;
+	for(int i=0;i<1000;i++)
+	{
+		int result = playGame(game, players);
+		if (result == 0) {
 			cout << "Team 1 win\n";
 			win1++;
 		}
+		else if (result == -1) {
+			cout << "Draw\n";
+		}
 		else {
 			cout << "Team 2 win\n";
 			win2++;
 		}
-		for (int i = 0; i < agents.size(); i++) {
-			agents[i].clear();
-		}
-		agents.clear();
-		cards.clear();
-		bank.arr.clear();
-		table.beaten.clear();
-		table.atk.clear();
-		table.temp.clear();
 	}
 	cout <<'\n' << win1 << " : " << win2;
-}
\ No newline at end of file
+}